@@ -0,0 +1,27 @@
+/* @file bench.h
+ * @brief helpers shared by the benchmarks
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <time.h>
+
+/* wall clock in seconds */
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* xorshift64, *state* should not be zero */
+static inline unsigned long bench_rand(unsigned long *state)
+{
+    unsigned long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#endif /* end of include guard: BENCH_H */
@@ -0,0 +1,134 @@
+/* @file ctable_bench.c
+ * @brief scaling of ctable against a table_t guarded by one mutex
+ *
+ * usage: ctable_bench [max threads] [keys] [ops per thread]
+ *
+ * For 1, 2, 4 ... max threads and several read ratios, every thread runs a
+ * random mix of get and put/remove over the same key space.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <table.h>
+#include <ctable.h>
+#include <mem.h>
+#include "bench.h"
+
+static int nkeys = 1 << 20;
+static int nops = 1 << 20;
+static int *keys;
+
+struct job {
+    int read_pct;
+    unsigned long seed;
+    ctable_t ctable;
+    table_t table;
+    pthread_mutex_t *lock;
+};
+
+static void *run_ctable(void *arg)
+{
+    struct job *job = arg;
+    int i;
+    for (i = 0; i < nops; i++) {
+        unsigned long r = bench_rand(&job->seed);
+        int *key = &keys[(r >> 8) % nkeys];
+        if ((int)(r % 100) < job->read_pct) {
+            ctable_get(job->ctable, key);
+        } else if (r & 0x80) {
+            ctable_put(job->ctable, key, key);
+        } else {
+            ctable_remove(job->ctable, key);
+        }
+    }
+    return NULL;
+}
+
+static void *run_table(void *arg)
+{
+    struct job *job = arg;
+    int i;
+    for (i = 0; i < nops; i++) {
+        unsigned long r = bench_rand(&job->seed);
+        int *key = &keys[(r >> 8) % nkeys];
+        pthread_mutex_lock(job->lock);
+        if ((int)(r % 100) < job->read_pct) {
+            table_get(job->table, key);
+        } else if (r & 0x80) {
+            table_put(job->table, key, key);
+        } else {
+            table_remove(job->table, key);
+        }
+        pthread_mutex_unlock(job->lock);
+    }
+    return NULL;
+}
+
+/* run *fn* on *nthreads* threads, return million operations per second */
+static double run(void *fn(void *), int nthreads, struct job *proto)
+{
+    pthread_t *tid = zalloc(nthreads * sizeof(*tid));
+    struct job *jobs = zalloc(nthreads * sizeof(*jobs));
+    double start, elapsed;
+    int i;
+
+    start = bench_now();
+    for (i = 0; i < nthreads; i++) {
+        jobs[i] = *proto;
+        jobs[i].seed = 88172645463325252UL + i;
+        pthread_create(&tid[i], NULL, fn, &jobs[i]);
+    }
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(tid[i], NULL);
+    }
+    elapsed = bench_now() - start;
+
+    zfree(jobs);
+    zfree(tid);
+    return (double)nthreads * nops / elapsed / 1e6;
+}
+
+int main(int argc, const char *argv[])
+{
+    static int read_pcts[] = {100, 90, 50};
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    int max_threads = argc > 1 ? atoi(argv[1]) : 32;
+    int i, r, n;
+
+    if (argc > 2) {
+        nkeys = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        nops = atoi(argv[3]);
+    }
+    keys = zalloc(nkeys * sizeof(*keys));
+
+    printf("%-8s %-6s %14s %14s\n", "threads", "read%", "ctable Mops/s",
+           "mutex Mops/s");
+    for (r = 0; r < (int)(sizeof(read_pcts)/sizeof(read_pcts[0])); r++) {
+        for (n = 1; n <= max_threads; n <<= 1) {
+            struct job job = {read_pcts[r], 0, NULL, NULL, &lock};
+            double c, t;
+
+            /* fill half of the key space, so puts and removes keep the
+             * size steady */
+            job.ctable = ctable_new(nkeys, NULL, NULL);
+            job.table = table_new(nkeys, NULL, NULL);
+            for (i = 0; i < nkeys; i += 2) {
+                ctable_put(job.ctable, &keys[i], &keys[i]);
+                table_put(job.table, &keys[i], &keys[i]);
+            }
+
+            c = run(run_ctable, n, &job);
+            t = run(run_table, n, &job);
+            printf("%-8d %-6d %14.2f %14.2f\n", n, read_pcts[r], c, t);
+
+            ctable_free(&job.ctable, NULL);
+            table_free(&job.table, NULL);
+        }
+    }
+
+    zfree(keys);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/* @file fset_bench.c
+ * @brief set algebra of fset against set_t
+ *
+ * usage: fset_bench [members]
+ *
+ * Two sets of *members* pointers overlap by half, the time to build the
+ * flat sets from the hashed ones is reported apart.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <set.h>
+#include <fset.h>
+#include <mem.h>
+#include "bench.h"
+
+#define NOPS 3
+
+int main(int argc, const char *argv[])
+{
+    static const char *names[NOPS] = {"inter", "union", "minus"};
+    static set_t (*set_ops[NOPS])(set_t, set_t) = {set_inter, set_union,
+        set_minus};
+    static fset_t (*fset_ops[NOPS])(fset_t, fset_t) = {fset_inter,
+        fset_union, fset_minus};
+    int nmembers = argc > 1 ? atoi(argv[1]) : 1 << 22;
+    long *members = zalloc((nmembers + nmembers / 2) * sizeof(*members));
+    set_t s, t, u;
+    fset_t fs, ft, fu;
+    double start, ts, tf;
+    int i;
+
+    s = set_new(nmembers, NULL, NULL);
+    t = set_new(nmembers, NULL, NULL);
+    for (i = 0; i < nmembers; i++) {
+        set_put(s, &members[i]);
+        set_put(t, &members[i + nmembers / 2]);
+    }
+    start = bench_now();
+    fs = set_freeze(s, NULL);
+    ft = set_freeze(t, NULL);
+    printf("%d members, set_freeze %.3f s\n", nmembers, bench_now() - start);
+    printf("%-8s %14s %14s\n", "op", "set Mkeys/s", "fset Mkeys/s");
+
+    for (i = 0; i < NOPS; i++) {
+        start = bench_now();
+        u = set_ops[i](s, t);
+        ts = bench_now() - start;
+        start = bench_now();
+        fu = fset_ops[i](fs, ft);
+        tf = bench_now() - start;
+        if (set_length(u) != fset_length(fu)) {
+            printf("%s: results differ\n", names[i]);
+        }
+        printf("%-8s %14.2f %14.2f\n", names[i], 2.0 * nmembers / ts / 1e6,
+               2.0 * nmembers / tf / 1e6);
+        set_free(&u, NULL);
+        fset_free(&fu);
+    }
+
+    fset_free(&fs);
+    fset_free(&ft);
+    set_free(&s, NULL);
+    set_free(&t, NULL);
+    zfree(members);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/* @file itable_bench.c
+ * @brief itable against table_t with the default cmp and hash
+ *
+ * usage: itable_bench [keys] [lookups]
+ *
+ * Keys are pointers into an array, as *xref* uses atoms; table_t hashes
+ * them with `key >> 2` and compares them through function pointers.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <table.h>
+#include <itable.h>
+#include <mem.h>
+#include "bench.h"
+
+int main(int argc, const char *argv[])
+{
+    int nkeys = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    int nprobes = argc > 2 ? atoi(argv[2]) : 1 << 23;
+    unsigned long seed = 88172645463325252UL;
+    long *keys = zalloc(nkeys * sizeof(*keys));
+    int *probes = zalloc(nprobes * sizeof(*probes));
+    table_t table;
+    itable_t itable;
+    double start, tput, iput, tget, iget;
+    long found;
+    int i;
+
+    for (i = 0; i < nprobes; i++) {
+        probes[i] = bench_rand(&seed) % nkeys;
+    }
+
+    start = bench_now();
+    table = table_new(nkeys, NULL, NULL);
+    for (i = 0; i < nkeys; i++) {
+        table_put(table, &keys[i], &keys[i]);
+    }
+    tput = bench_now() - start;
+
+    start = bench_now();
+    itable = itable_new(nkeys);
+    for (i = 0; i < nkeys; i++) {
+        itable_put(itable, (unsigned long)&keys[i], &keys[i]);
+    }
+    iput = bench_now() - start;
+
+    found = 0;
+    start = bench_now();
+    for (i = 0; i < nprobes; i++) {
+        found += table_get(table, &keys[probes[i]]) != NULL;
+    }
+    tget = bench_now() - start;
+
+    start = bench_now();
+    for (i = 0; i < nprobes; i++) {
+        found -= itable_get(itable, (unsigned long)&keys[probes[i]]) != NULL;
+    }
+    iget = bench_now() - start;
+
+    printf("%d keys, %d lookups%s\n", nkeys, nprobes,
+           found ? " (MISMATCH)" : "");
+    printf("%-8s %14s %14s\n", "", "put Mops/s", "get Mops/s");
+    printf("%-8s %14.2f %14.2f\n", "table", nkeys / tput / 1e6,
+           nprobes / tget / 1e6);
+    printf("%-8s %14.2f %14.2f\n", "itable", nkeys / iput / 1e6,
+           nprobes / iget / 1e6);
+
+    table_free(&table, NULL);
+    itable_free(&itable);
+    zfree(probes);
+    zfree(keys);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/* @file set_bench.c
+ * @brief lookup and algebra throughput of set_t
+ *
+ * usage: set_bench [members] [lookups]
+ *
+ * Two sets of *members* pointers overlap by half. Members are inserted in a
+ * random order so that chains are scattered over the heap; choose *members*
+ * well beyond the last level cache to see memory latency.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <set.h>
+#include <mem.h>
+#include "bench.h"
+
+static void shuffle(const void **a, int n, unsigned long *seed)
+{
+    int i;
+    for (i = n - 1; i > 0; i--) {
+        int j = bench_rand(seed) % (i + 1);
+        const void *t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+/* time *op* on s and t, print the members per second of s and t */
+static void run(const char *name, set_t op(set_t, set_t), set_t s, set_t t)
+{
+    double start = bench_now(), elapsed;
+    set_t u = op(s, t);
+    elapsed = bench_now() - start;
+    printf("%-12s %8.2f Mmembers/s (%d members)\n", name,
+           (set_length(s) + set_length(t)) / elapsed / 1e6, set_length(u));
+    set_free(&u, NULL);
+}
+
+int main(int argc, const char *argv[])
+{
+    int nmembers = argc > 1 ? atoi(argv[1]) : 1 << 22;
+    int nprobes = argc > 2 ? atoi(argv[2]) : 1 << 22;
+    unsigned long seed = 88172645463325252UL;
+    int total = nmembers + nmembers / 2;
+    long *members = zalloc(total * sizeof(*members));
+    const void **order = zalloc(total * sizeof(*order));
+    const void **probes = zalloc(nprobes * sizeof(*probes));
+    bit_t in = bit_new(nprobes);
+    set_t s, t;
+    double start, elapsed;
+    long found;
+    int i;
+
+    for (i = 0; i < total; i++) {
+        order[i] = &members[i];
+    }
+    shuffle(order, total, &seed);
+    s = set_new(nmembers, NULL, NULL);
+    t = set_new(nmembers, NULL, NULL);
+    for (i = 0; i < total; i++) {
+        long *m = (long *)order[i];
+        if (m < members + nmembers) {
+            set_put(s, m);
+        }
+        if (m >= members + nmembers / 2) {
+            set_put(t, m);
+        }
+    }
+
+    /* a third of the probes miss */
+    for (i = 0; i < nprobes; i++) {
+        probes[i] = &members[bench_rand(&seed) % total];
+    }
+
+    printf("%d members, %d lookups\n", nmembers, nprobes);
+
+    found = 0;
+    start = bench_now();
+    for (i = 0; i < nprobes; i++) {
+        found += set_member(s, probes[i]);
+    }
+    elapsed = bench_now() - start;
+    printf("%-12s %8.2f Mops/s (%ld found)\n", "set_member",
+           nprobes / elapsed / 1e6, found);
+
+    start = bench_now();
+    set_member_batch(s, probes, nprobes, in);
+    elapsed = bench_now() - start;
+    printf("%-12s %8.2f Mops/s (%d found)\n", "member_batch",
+           nprobes / elapsed / 1e6, bit_count(in));
+
+    run("set_union", set_union, s, t);
+    run("set_inter", set_inter, s, t);
+    run("set_minus", set_minus, s, t);
+    run("set_diff", set_diff, s, t);
+
+    set_free(&s, NULL);
+    set_free(&t, NULL);
+    bit_free(&in);
+    zfree(probes);
+    zfree(order);
+    zfree(members);
+    return 0;
+}
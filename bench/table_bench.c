@@ -0,0 +1,161 @@
+/* @file table_bench.c
+ * @brief lookup and churn throughput of table_t
+ *
+ * usage: table_bench [keys] [lookups]
+ *
+ * The keys are pointers into an array, bindings are inserted in a random
+ * order so that chains are scattered over the heap; choose *keys* well
+ * beyond the last level cache to see memory latency.
+ *
+ * Half of the lookups miss, they are run again with a Bloom filter in front
+ * of the table. Then only misses are looked up, with and without the filter:
+ * the filter pays off when most lookups miss.
+ *
+ * The churn test keeps half of the keys in a table, and every step removes
+ * the oldest key and puts a new one, with and without *table_recycle*.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <table.h>
+#include <mem.h>
+#include "bench.h"
+
+#define BATCH 1024
+
+static void shuffle(const void **a, int n, unsigned long *seed)
+{
+    int i;
+    for (i = n - 1; i > 0; i--) {
+        int j = bench_rand(seed) % (i + 1);
+        const void *t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+/* *n* steps of remove/put on a table holding half of *keys* */
+static double churn(const void **keys, int nkeys, int n, int cap)
+{
+    table_t table = table_new(nkeys / 2, NULL, NULL);
+    double start, t;
+    int i, half = nkeys / 2;
+
+    table_recycle(table, cap);
+    for (i = 0; i < half; i++) {
+        table_put(table, keys[i], (void *)keys[i]);
+    }
+
+    start = bench_now();
+    for (i = 0; i < n; i++) {
+        const void *key = keys[(i + half) % nkeys];
+        table_remove(table, keys[i % nkeys]);
+        table_put(table, key, (void *)key);
+    }
+    t = bench_now() - start;
+
+    table_free(&table, NULL);
+    return n / t / 1e6;
+}
+
+/* look up *n* absent keys */
+static double misses(table_t table, const void **probes, int n)
+{
+    double start = bench_now();
+    long found = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        found += table_get(table, probes[i]) != NULL;
+    }
+    if (found) {
+        printf("a missing key is found\n");
+    }
+    return n / (bench_now() - start) / 1e6;
+}
+
+int main(int argc, const char *argv[])
+{
+    int nkeys = argc > 1 ? atoi(argv[1]) : 1 << 22;
+    int nprobes = argc > 2 ? atoi(argv[2]) : 1 << 22;
+    unsigned long seed = 88172645463325252UL;
+    long *keys = zalloc(nkeys * sizeof(*keys));
+    const void **order = zalloc(nkeys * sizeof(*order));
+    const void **probes = zalloc(nprobes * sizeof(*probes));
+    void *values[BATCH];
+    table_t table;
+    double start, t;
+    long found;
+    int i, j;
+
+    for (i = 0; i < nkeys; i++) {
+        order[i] = &keys[i];
+    }
+    shuffle(order, nkeys, &seed);
+    table = table_new(nkeys, NULL, NULL);
+    for (i = 0; i < nkeys; i++) {
+        table_put(table, order[i], &keys[i]);
+    }
+
+    /* half of the probes miss */
+    for (i = 0; i < nprobes; i++) {
+        unsigned long r = bench_rand(&seed);
+        probes[i] = (r & 1) ? (const void *)&keys[(r >> 1) % nkeys]
+                            : (const void *)&order[(r >> 1) % nkeys];
+    }
+
+    printf("%d keys, %d lookups\n", nkeys, nprobes);
+
+    found = 0;
+    start = bench_now();
+    for (i = 0; i < nprobes; i++) {
+        found += table_get(table, probes[i]) != NULL;
+    }
+    t = bench_now() - start;
+    printf("%-16s %8.2f Mops/s (%ld found)\n", "table_get", nprobes / t / 1e6,
+           found);
+
+    found = 0;
+    start = bench_now();
+    for (i = 0; i < nprobes; i += BATCH) {
+        int m = (nprobes - i < BATCH) ? nprobes - i : BATCH;
+        table_get_batch(table, probes + i, m, values);
+        for (j = 0; j < m; j++) {
+            found += values[j] != NULL;
+        }
+    }
+    t = bench_now() - start;
+    printf("%-16s %8.2f Mops/s (%ld found)\n", "table_get_batch",
+           nprobes / t / 1e6, found);
+
+    /* the same lookups, with misses rejected by a Bloom filter */
+    table_bloom(table, nkeys);
+    found = 0;
+    start = bench_now();
+    for (i = 0; i < nprobes; i++) {
+        found += table_get(table, probes[i]) != NULL;
+    }
+    t = bench_now() - start;
+    printf("%-16s %8.2f Mops/s (%ld found)\n", "table_get bloom",
+           nprobes / t / 1e6, found);
+
+    for (i = 0; i < nprobes; i++) {
+        probes[i] = &order[bench_rand(&seed) % nkeys];
+    }
+    printf("%-16s %8.2f Mops/s\n", "misses bloom",
+           misses(table, probes, nprobes));
+    table_bloom(table, 0);
+    printf("%-16s %8.2f Mops/s\n", "misses",
+           misses(table, probes, nprobes));
+
+    table_free(&table, NULL);
+
+    printf("%-16s %8.2f Mops/s\n", "churn", churn(order, nkeys, nprobes, 0));
+    printf("%-16s %8.2f Mops/s\n", "churn recycled",
+           churn(order, nkeys, nprobes, 1024));
+
+    zfree(probes);
+    zfree(order);
+    zfree(keys);
+    return 0;
+}
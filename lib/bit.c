@@ -72,7 +72,7 @@ int bit_count(T set)
     static char count[] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
 
     assert(set);
-    for (i = nbytes(set->length); --i > 0; ) {
+    for (i = nbytes(set->length); --i >= 0; ) {
         unsigned char c = set->bytes[i];
         length += count[c & 0x0F] + count[(c >> 4) & 0x0F];
     }
@@ -0,0 +1,158 @@
+/* implementation of *bloom*
+ */
+#include <stdint.h>
+#include <assert.h>
+
+#include "bloom.h"
+#include "mem.h"
+
+#define T bloom_t
+
+/* a block is one cache line of 512 bits, every key sets K of its bits */
+#define BLOCK_WORDS 8
+#define BLOCK_BITS (BLOCK_WORDS * 64)
+#define K 7
+/* bits per expected key, about 1% false positives for blocks of 512 bits */
+#define BITS_PER_KEY 10
+
+struct T {
+    int nblocks;
+    uint64_t (*blocks)[BLOCK_WORDS];    /* aligned on 64 bytes */
+    void *mem;                          /* what was allocated */
+    bool counting;          /* the counters below are only kept if set */
+    long queries;
+    long rejected;
+    long false_positives;
+};
+
+/* spread the 32 bits of *h* over 64 */
+static inline uint64_t mix(unsigned h)
+{
+    uint64_t x = (uint64_t)h * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 32;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+    return x;
+}
+
+T bloom_new(int expected)
+{
+    T bloom;
+    uintptr_t p;
+
+    assert(expected >= 0);
+
+    bloom = (T)zalloc(sizeof(*bloom));
+    bloom->nblocks = ((long)expected * BITS_PER_KEY + BLOCK_BITS - 1)
+                     / BLOCK_BITS;
+    bloom->nblocks = bloom->nblocks > 0 ? bloom->nblocks : 1;
+    bloom->mem = zcalloc(bloom->nblocks + 1, sizeof(bloom->blocks[0]));
+    p = ((uintptr_t)bloom->mem + sizeof(bloom->blocks[0]) - 1)
+        & ~(uintptr_t)(sizeof(bloom->blocks[0]) - 1);
+    bloom->blocks = (uint64_t (*)[BLOCK_WORDS])p;
+    bloom->counting = false;
+    bloom->queries = 0;
+    bloom->rejected = 0;
+    bloom->false_positives = 0;
+
+    return bloom;
+}
+
+void bloom_free(T *bloom)
+{
+    assert(bloom && *bloom);
+    zfree((*bloom)->mem);
+    zfree(*bloom);
+    *bloom = NULL;
+}
+
+/* the block of the key and the two hashes that give its bits, the i-th bit
+ * is (h1 + i * h2) % BLOCK_BITS. The block takes the high 32 bits of the
+ * mix, h1 its low 9 bits and h2 the next 23: keys of the same block must
+ * not share their bits within it */
+#define locate(bloom, hash, block, h1, h2) do { \
+    uint64_t x = mix(hash); \
+    block = (bloom)->blocks[((x >> 32) * (bloom)->nblocks) >> 32]; \
+    h1 = (uint32_t)x; \
+    h2 = ((uint32_t)x >> 9) | 1; \
+} while (0)
+
+void bloom_add(T bloom, unsigned hash)
+{
+    uint64_t *block;
+    uint32_t h1, h2, bit;
+    int i;
+
+    assert(bloom);
+    locate(bloom, hash, block, h1, h2);
+    for (i = 0; i < K; i++) {
+        bit = (h1 + i * h2) % BLOCK_BITS;
+        block[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+}
+
+/* are all the bits of the key of hash *hash* set? */
+static inline bool contains(T bloom, unsigned hash)
+{
+    uint64_t *block;
+    uint32_t h1, h2, bit;
+    int i;
+
+    locate(bloom, hash, block, h1, h2);
+    for (i = 0; i < K; i++) {
+        bit = (h1 + i * h2) % BLOCK_BITS;
+        if (!(block[bit / 64] & ((uint64_t)1 << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bloom_test(T bloom, unsigned hash)
+{
+    bool found;
+
+    assert(bloom);
+    found = contains(bloom, hash);
+    if (bloom->counting) {
+        bloom->queries ++;
+        bloom->rejected += !found;
+    }
+    return found;
+}
+
+void bloom_false_positive(T bloom)
+{
+    assert(bloom);
+    if (bloom->counting) {
+        bloom->false_positives ++;
+    }
+}
+
+void bloom_count(T bloom, bool on)
+{
+    assert(bloom);
+    bloom->counting = on;
+}
+
+void bloom_stats(T bloom, long *queries, long *rejected,
+                 long *false_positives)
+{
+    assert(bloom);
+    if (queries) {
+        *queries = bloom->queries;
+    }
+    if (rejected) {
+        *rejected = bloom->rejected;
+    }
+    if (false_positives) {
+        *false_positives = bloom->false_positives;
+    }
+}
+
+long bloom_memory_usage(T bloom)
+{
+    assert(bloom);
+    return sizeof(*bloom)
+        + (long)(bloom->nblocks + 1) * sizeof(bloom->blocks[0]);
+}
@@ -0,0 +1,63 @@
+/** @file bloom.h
+ * @brief blocked Bloom filters over 32-bit hashes.
+ *
+ * A Bloom filter answers "maybe present" or "surely absent". This one
+ * keeps every key in a single 64-byte block, so a query reads one cache
+ * line. It is meant to sit in front of a *table* or a *set* (see
+ * *table_bloom* and *set_bloom*) and is fed with the hashes they already
+ * compute, so it never calls *hash* itself.
+ *
+ * Keys can not be removed from a filter, a removed key only stays a "maybe".
+ *
+ * Testing a key only reads the filter, several threads can test it at once,
+ * unless its counters are turned on with *bloom_count*.
+ */
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stdbool.h>
+
+#define T bloom_t
+typedef struct T *T;
+
+/** @brief create a filter for about *expected* keys, with about 1% false
+ * positives at that count */
+extern T bloom_new(int expected);
+
+/** @brief free a filter */
+extern void bloom_free(T *bloom);
+
+/** @brief add the key of hash *hash* */
+extern void bloom_add(T bloom, unsigned hash);
+
+/** @brief test a key by its hash, counting the query if counters are on
+ * @return false if the key was never added, true if it may have been.
+ */
+extern bool bloom_test(T bloom, unsigned hash);
+
+/** @brief record that the last *bloom_test* returning true was wrong, if
+ * counters are on */
+extern void bloom_false_positive(T bloom);
+
+/** @brief turn the counters read by *bloom_stats* on or off, they are off
+ * in a new filter. Counting writes to the filter on every test, it costs
+ * two stores per lookup and makes concurrent lookups a data race: turn it
+ * on to measure a filter used by one thread.
+ */
+extern void bloom_count(T bloom, bool on);
+
+/** @brief read the counters of the filter, see *bloom_count*
+ * @param queries calls of *bloom_test*
+ * @param rejected queries answered "absent"
+ * @param false_positives queries answered "maybe" for an absent key, as
+ * reported by *bloom_false_positive*.
+ * Any of them can be NULL.
+ */
+extern void bloom_stats(T bloom, long *queries, long *rejected,
+                        long *false_positives);
+
+/** @brief return the number of bytes used by the filter */
+extern long bloom_memory_usage(T bloom);
+
+#undef T
+#endif /* end of include guard: BLOOM_H */
@@ -0,0 +1,277 @@
+/* implementation of *cache*
+ */
+#include <limits.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "cache.h"
+#include "table.h"
+#include "mem.h"
+
+#define T cache_t
+
+/* a table keeps the buckets of its hint, so the index is rebuilt for twice
+ * its entries once they are more than MAX_LOAD times its hint. The table of
+ * a cache bounded by bytes only starts small and takes about MIN_HINT
+ * buckets past a few entries */
+#define MAX_LOAD 2
+#define MIN_HINT 512
+
+/* The table maps every key to its entry, the entries form a circular doubly
+ * linked list through *head*, like a ring. ring_t itself hands out indexes,
+ * not nodes, so it cannot unlink an entry in constant time.
+ *
+ * LRU:   head.next is the most recently used entry, head.prev the victim.
+ * CLOCK: the list is the clock face, new entries go right behind the hand.
+ */
+struct T {
+    table_t table;
+    int hint;               /* about the buckets of *table* */
+    struct entry {
+        struct entry *next;
+        struct entry *prev;
+        const void *key;
+        void *value;
+        long size;
+        int referenced;
+    } head, *hand;
+    int policy;
+    int max_entries;
+    long max_bytes;
+    long bytes;
+    long hits, misses, evictions;
+    void (*evict)(const void *key, void *value, void *cl);
+    void *cl;
+};
+
+static inline void unlink_entry(struct entry *e)
+{
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+}
+
+/* insert *e* before *pos* */
+static inline void link_before(struct entry *pos, struct entry *e)
+{
+    e->next = pos;
+    e->prev = pos->prev;
+    pos->prev->next = e;
+    pos->prev = e;
+}
+
+T cache_new(int max_entries, long max_bytes, int policy,
+            int cmp(const void *a, const void *b),
+            unsigned hash(const void *key),
+            void evict(const void *key, void *value, void *cl),
+            void *cl)
+{
+    T cache;
+
+    assert(max_entries >= 0);
+    assert(max_bytes >= 0);
+    assert(policy == CACHE_LRU || policy == CACHE_CLOCK);
+
+    cache = (T)zcalloc(1, sizeof(*cache));
+    cache->hint = max_entries ? max_entries : MIN_HINT;
+    cache->table = table_new(max_entries, cmp, hash);
+    cache->head.next = &cache->head;
+    cache->head.prev = &cache->head;
+    cache->hand = &cache->head;
+    cache->policy = policy;
+    cache->max_entries = max_entries;
+    cache->max_bytes = max_bytes;
+    cache->evict = evict;
+    cache->cl = cl;
+
+    return cache;
+}
+
+void cache_free(T *cache, void destroy(const void *key, void *value))
+{
+    struct entry *e, *next;
+    struct entry *head;
+
+    assert(cache && *cache);
+    head = &(*cache)->head;
+    for (e = head->next; e != head; e = next) {
+        next = e->next;
+        if (destroy) {
+            destroy(e->key, e->value);
+        }
+        zfree(e);
+    }
+    table_free(&(*cache)->table, NULL);
+    zfree(*cache);
+    *cache = NULL;
+}
+
+int cache_length(T cache)
+{
+    assert(cache);
+    return table_length(cache->table);
+}
+
+long cache_bytes(T cache)
+{
+    assert(cache);
+    return cache->bytes;
+}
+
+void *cache_get(T cache, const void *key)
+{
+    struct entry *e;
+
+    assert(cache);
+    assert(key);
+
+    e = table_get(cache->table, key);
+    if (e == NULL) {
+        cache->misses ++;
+        return NULL;
+    }
+
+    cache->hits ++;
+    if (cache->policy == CACHE_LRU) {
+        unlink_entry(e);
+        link_before(cache->head.next, e);
+    } else {
+        e->referenced = 1;
+    }
+    return e->value;
+}
+
+/* detach *e* from the list and the table */
+static void drop(T cache, struct entry *e)
+{
+    if (cache->hand == e) {
+        cache->hand = e->next;
+    }
+    unlink_entry(e);
+    table_remove(cache->table, e->key);
+    cache->bytes -= e->size;
+}
+
+/* pick the entry to evict, the cache is not empty */
+static struct entry *victim(T cache)
+{
+    struct entry *e;
+
+    if (cache->policy == CACHE_LRU) {
+        return cache->head.prev;
+    }
+
+    for (;;) {
+        e = cache->hand;
+        cache->hand = e->next;
+        if (e == &cache->head) {
+            continue;
+        }
+        if (!e->referenced) {
+            return e;
+        }
+        e->referenced = 0;
+    }
+}
+
+static inline int over(T cache)
+{
+    return (cache->max_entries && table_length(cache->table) > cache->max_entries)
+        || (cache->max_bytes && cache->bytes > cache->max_bytes);
+}
+
+/* move the entries to an index sized for them, the bindings are relinked,
+ * not copied */
+static void rehash(T cache)
+{
+    table_t table;
+    int n = table_length(cache->table);
+
+    cache->hint = n < INT_MAX / 2 ? 2 * n : INT_MAX;
+    table = table_new(cache->hint, table_cmp(cache->table),
+                      table_hash(cache->table));
+    table_merge(table, cache->table, NULL, NULL);
+    table_free(&cache->table, NULL);
+    cache->table = table;
+}
+
+void *cache_put(T cache, const void *key, void *value, long size)
+{
+    struct entry *e;
+    void *prev = NULL;
+
+    assert(cache);
+    assert(key);
+    assert(size >= 0);
+
+    e = table_get(cache->table, key);
+    if (e) {
+        prev = e->value;
+        cache->bytes += size - e->size;
+        if (cache->policy == CACHE_LRU) {
+            unlink_entry(e);
+            link_before(cache->head.next, e);
+        } else {
+            e->referenced = 1;
+        }
+    } else {
+        e = (struct entry *)zalloc(sizeof(*e));
+        e->key = key;
+        e->referenced = 0;
+        cache->bytes += size;
+        if (cache->policy == CACHE_LRU) {
+            link_before(cache->head.next, e);
+        } else {
+            link_before(cache->hand, e);
+        }
+        table_put(cache->table, key, e);
+        if (table_length(cache->table) > (long)MAX_LOAD * cache->hint) {
+            rehash(cache);
+        }
+    }
+    e->value = value;
+    e->size = size;
+
+    while (over(cache)) {
+        struct entry *v = victim(cache);
+        drop(cache, v);
+        cache->evictions ++;
+        if (cache->evict) {
+            cache->evict(v->key, v->value, cache->cl);
+        }
+        zfree(v);
+    }
+
+    return prev;
+}
+
+void *cache_remove(T cache, const void *key)
+{
+    struct entry *e;
+    void *value;
+
+    assert(cache);
+    assert(key);
+
+    e = table_get(cache->table, key);
+    if (e == NULL) {
+        return NULL;
+    }
+    drop(cache, e);
+    value = e->value;
+    zfree(e);
+    return value;
+}
+
+void cache_stats(T cache, long *hits, long *misses, long *evictions)
+{
+    assert(cache);
+    if (hits) {
+        *hits = cache->hits;
+    }
+    if (misses) {
+        *misses = cache->misses;
+    }
+    if (evictions) {
+        *evictions = cache->evictions;
+    }
+}
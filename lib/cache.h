@@ -0,0 +1,71 @@
+/** @file cache.h
+ * @brief a bounded cache built on *table*.
+ *
+ * A cache maps keys to values like a table, but it holds at most a given
+ * number of entries and/or bytes. When a put goes over either limit, entries
+ * are evicted according to the policy of the cache:
+ *
+ * CACHE_LRU    evicts the least recently used entry.
+ * CACHE_CLOCK  approximates LRU: a hit only sets a reference bit, and the
+ *              clock hand evicts the first entry it finds without one,
+ *              clearing the bits it passes.
+ *
+ * Gets and puts take constant time, and a get never allocates memory.
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#define T cache_t
+typedef struct T *T;
+
+enum { CACHE_LRU, CACHE_CLOCK };
+
+/** @brief create a new cache
+ * @param max_entries the maximal number of entries, 0 for no limit.
+ * @param max_bytes the maximal sum of the sizes given to *cache_put*, 0 for
+ * no limit.
+ * @param policy CACHE_LRU or CACHE_CLOCK
+ * @param cmp, hash same as *table_new*, NULL for the defaults.
+ * @param evict called on every evicted entry, can be NULL.
+ * @param cl the client-specific pointer passed to *evict*
+ * @return a new cache.
+ */
+extern T cache_new(int max_entries, long max_bytes, int policy,
+                   int cmp(const void *a, const void *b),
+                   unsigned hash(const void *key),
+                   void evict(const void *key, void *value, void *cl),
+                   void *cl);
+
+/** @brief free a cache
+ * @param destroy called on every entry left, can be NULL.
+ */
+extern void cache_free(T *cache, void destroy(const void *key, void *value));
+
+/** @brief return the number of entries */
+extern int cache_length(T cache);
+
+/** @brief return the sum of the sizes of the entries */
+extern long cache_bytes(T cache);
+
+/** @brief return the value of *key* and mark it as used
+ * @return the value, NULL on a miss.
+ */
+extern void *cache_get(T cache, const void *key);
+
+/** @brief bind *value* of *size* bytes to *key*, then evict entries until the
+ * cache is within its limits.
+ * @return the previous value of *key*, NULL if there was none. The previous
+ * value is not passed to *evict*.
+ */
+extern void *cache_put(T cache, const void *key, void *value, long size);
+
+/** @brief remove *key* without calling *evict*
+ * @return the removed value, NULL if not found.
+ */
+extern void *cache_remove(T cache, const void *key);
+
+/** @brief return the counters of the cache, any pointer can be NULL */
+extern void cache_stats(T cache, long *hits, long *misses, long *evictions);
+
+#undef T
+#endif /* end of include guard: CACHE_H */
@@ -0,0 +1,266 @@
+/* implementation of *ctable*
+ */
+#include <limits.h>
+#include <stddef.h>
+#include <assert.h>
+#include <pthread.h>
+#include "ctable.h"
+#include "mem.h"
+
+#define T ctable_t
+
+/* number of locks, a power of two. The bucket array is never smaller than
+ * this, so that a bucket always belongs to the same stripe:
+ *     bucket & (NSTRIPES-1) == hash & (NSTRIPES-1)
+ * no matter how many times the table is resized. */
+#define NSTRIPES 64
+
+/* grow the buckets when the average chain is longer than this */
+#define MAX_LOAD 2
+
+struct T {
+    struct binding {
+        struct binding *link;
+        const void *key;
+        void *value;
+        unsigned hash;      /* mixed hash, saves calling *hash* on resize */
+    } **buckets;
+    int size;               /* a power of two, changed only with all stripes
+                               locked */
+    int length;             /* updated atomically */
+    int (*cmp)(const void *a, const void *b);
+    unsigned (*hash)(const void *key);
+    pthread_rwlock_t stripes[NSTRIPES];
+};
+
+static unsigned default_hash(const void *key)
+{
+    return (unsigned long)key >> 2;
+}
+
+static int default_cmp(const void *a, const void *b)
+{
+    return a != b;
+}
+
+/* the bucket index is taken from the low bits, spread the user's hash so
+ * that `key >> 2` style hashes do not pile up in a few stripes */
+static inline unsigned mix(unsigned h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+#define stripe(table, h) (&(table)->stripes[(h) & (NSTRIPES-1)])
+
+T ctable_new(int hint,
+             int cmp(const void *a, const void *b),
+             unsigned hash(const void *key))
+{
+    T table;
+    int i;
+
+    assert(hint >= 0);
+    table = (T)zalloc(sizeof(*table));
+    for (table->size = NSTRIPES; table->size < hint/MAX_LOAD
+            && table->size < INT_MAX/2; table->size <<= 1) {
+        /* pass */
+    }
+    table->buckets = zcalloc(table->size, sizeof(table->buckets[0]));
+    table->length = 0;
+    table->cmp = cmp ? cmp : default_cmp;
+    table->hash = hash ? hash : default_hash;
+    for (i = 0; i < NSTRIPES; i++) {
+        pthread_rwlock_init(&table->stripes[i], NULL);
+    }
+
+    return table;
+}
+
+/* find the binding of *key* in the bucket of *h*, the stripe of *h* should
+ * be held */
+static struct binding **lookup(T table, const void *key, unsigned h)
+{
+    struct binding **pp;
+
+    pp = &table->buckets[h & (table->size - 1)];
+    for (; *pp; pp = &(*pp)->link) {
+        if ((*pp)->hash == h && (*table->cmp)(key, (*pp)->key) == 0) {
+            break;
+        }
+    }
+    return pp;
+}
+
+/* double the buckets, called without holding any stripe */
+static void grow(T table)
+{
+    int i;
+    struct binding **buckets, *p, *q;
+
+    for (i = 0; i < NSTRIPES; i++) {
+        pthread_rwlock_wrlock(&table->stripes[i]);
+    }
+
+    /* another thread may have grown the table before we get the locks */
+    if (table->length > MAX_LOAD * table->size && table->size < INT_MAX/2) {
+        int size = table->size << 1;
+
+        buckets = zcalloc(size, sizeof(buckets[0]));
+        for (i = 0; i < table->size; i++) {
+            for (p = table->buckets[i]; p; p = q) {
+                q = p->link;
+                p->link = buckets[p->hash & (size - 1)];
+                buckets[p->hash & (size - 1)] = p;
+            }
+        }
+        zfree(table->buckets);
+        table->buckets = buckets;
+        __atomic_store_n(&table->size, size, __ATOMIC_RELAXED);
+    }
+
+    for (i = NSTRIPES; --i >= 0; ) {
+        pthread_rwlock_unlock(&table->stripes[i]);
+    }
+}
+
+void *ctable_get(T table, const void *key)
+{
+    unsigned h;
+    void *value;
+    pthread_rwlock_t *lock;
+
+    assert(table);
+    assert(key);
+
+    h = mix((*table->hash)(key));
+    lock = stripe(table, h);
+    pthread_rwlock_rdlock(lock);
+    struct binding *p = *lookup(table, key, h);
+    value = p ? p->value : NULL;
+    pthread_rwlock_unlock(lock);
+
+    return value;
+}
+
+void *ctable_put(T table, const void *key, void *value)
+{
+    unsigned h;
+    struct binding **pp, *p;
+    void *prev;
+    pthread_rwlock_t *lock;
+    int length;
+
+    assert(table);
+    assert(key);
+
+    h = mix((*table->hash)(key));
+    lock = stripe(table, h);
+    pthread_rwlock_wrlock(lock);
+    pp = lookup(table, key, h);
+    if (*pp == NULL) {
+        p = (struct binding *)zalloc(sizeof(*p));
+        p->key = key;
+        p->hash = h;
+        p->link = NULL;
+        *pp = p;
+        prev = NULL;
+        length = __atomic_add_fetch(&table->length, 1, __ATOMIC_RELAXED);
+    } else {
+        p = *pp;
+        prev = p->value;
+        length = 0;
+    }
+    p->value = value;
+    pthread_rwlock_unlock(lock);
+
+    if (length > MAX_LOAD * __atomic_load_n(&table->size, __ATOMIC_RELAXED)) {
+        grow(table);
+    }
+
+    return prev;
+}
+
+void *ctable_remove(T table, const void *key)
+{
+    unsigned h;
+    struct binding **pp, *p;
+    void *value = NULL;
+    pthread_rwlock_t *lock;
+
+    assert(table);
+    assert(key);
+
+    h = mix((*table->hash)(key));
+    lock = stripe(table, h);
+    pthread_rwlock_wrlock(lock);
+    pp = lookup(table, key, h);
+    p = *pp;
+    if (p) {
+        *pp = p->link;
+        value = p->value;
+        __atomic_sub_fetch(&table->length, 1, __ATOMIC_RELAXED);
+    }
+    pthread_rwlock_unlock(lock);
+
+    if (p) {
+        zfree(p);
+    }
+    return value;
+}
+
+int ctable_length(T table)
+{
+    assert(table);
+    return __atomic_load_n(&table->length, __ATOMIC_RELAXED);
+}
+
+void ctable_map(T table,
+                void apply(const void *key, void **value, void *cl),
+                void *cl)
+{
+    int i;
+    struct binding *p;
+
+    assert(table);
+    assert(apply);
+
+    for (i = 0; i < NSTRIPES; i++) {
+        pthread_rwlock_wrlock(&table->stripes[i]);
+    }
+    for (i = 0; i < table->size; i++) {
+        for (p = table->buckets[i]; p; p = p->link) {
+            apply(p->key, &p->value, cl);
+        }
+    }
+    for (i = NSTRIPES; --i >= 0; ) {
+        pthread_rwlock_unlock(&table->stripes[i]);
+    }
+}
+
+void ctable_free(T *table, void (*destroy)(const void *key, void *value))
+{
+    int i;
+    struct binding *p, *q;
+
+    assert(table && *table);
+    for (i = 0; i < (*table)->size; i++) {
+        for (p = (*table)->buckets[i]; p; p = q) {
+            q = p->link;
+            if (destroy != NULL) {
+                destroy(p->key, p->value);
+            }
+            zfree(p);
+        }
+    }
+    for (i = 0; i < NSTRIPES; i++) {
+        pthread_rwlock_destroy(&(*table)->stripes[i]);
+    }
+    zfree((*table)->buckets);
+    zfree(*table);
+    *table = NULL;
+}
@@ -0,0 +1,60 @@
+/** @file ctable.h
+ * @brief a table that can be shared by several threads.
+ *
+ * ctable has the same key/value semantics as *table*: keys are compared with
+ * *cmp* and hashed with *hash*, NULL means default ones that compare and hash
+ * the pointers themselves.
+ *
+ * The buckets are guarded by a fixed number of reader-writer locks (stripes),
+ * so readers never block each other and writers only block the operations
+ * that fall into the same stripe. The table doubles its bucket array when the
+ * load gets too high; a resize takes every stripe and is therefore safe
+ * against all other operations.
+ */
+#ifndef CTABLE_H
+#define CTABLE_H
+
+#define T ctable_t
+typedef struct T *T;
+
+/** @brief create a new concurrent table
+ * @param hint the estimated number of entries.
+ * @param cmp the function used to compare keys, NULL for pointer equality.
+ * @param hash the hash function of keys, NULL for hashing the pointer.
+ * @return a new table.
+ */
+extern T ctable_new(int hint,
+                    int cmp(const void *a, const void *b),
+                    unsigned hash(const void *key));
+
+/** @brief free a table, no other thread should be using it.
+ * @param destroy called on every binding, can be NULL.
+ */
+extern void ctable_free(T *table, void (*destroy)(const void *key, void *value));
+
+/** @brief return the number of bindings in *table* */
+extern int ctable_length(T table);
+
+/** @brief bind *value* to *key*
+ * @return the previous value, NULL if *key* was not in the table.
+ */
+extern void *ctable_put(T table, const void *key, void *value);
+
+/** @brief return the value bound to *key*, NULL if not found */
+extern void *ctable_get(T table, const void *key);
+
+/** @brief remove the binding of *key*
+ * @return the removed value, NULL if not found.
+ */
+extern void *ctable_remove(T table, const void *key);
+
+/** @brief apply a function over all bindings.
+ * The whole table is locked while mapping, so *apply* may change the values
+ * but must not call other ctable functions on *table*.
+ */
+extern void ctable_map(T table,
+                       void apply(const void *key, void **value, void *cl),
+                       void *cl);
+
+#undef T
+#endif /* end of include guard: CTABLE_H */
@@ -0,0 +1,330 @@
+/* implementation of *fset*
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fset.h"
+#include "mem.h"
+
+/* the SSE2 intersection compares 64-bit keys */
+#if defined(__SSE2__) && __SIZEOF_LONG__ == 8
+#include <emmintrin.h>
+#define FSET_SSE2
+#endif
+
+#define T fset_t
+
+/* gallop through the larger set when it is that many times larger */
+#define GALLOP 32
+
+struct T {
+    int length;
+    unsigned long *keys;
+};
+
+/* a set with room for *n* keys, the caller sets the length */
+static T alloc(int n)
+{
+    T set = (T)zalloc(sizeof(*set));
+    set->length = 0;
+    set->keys = zalloc((n + 1) * sizeof(set->keys[0]));
+    return set;
+}
+
+/* give back the room of a result much smaller than its estimate */
+static T trim(T set, int n)
+{
+    unsigned long *keys;
+
+    if (set->length < n / 2) {
+        keys = zalloc((set->length + 1) * sizeof(*keys));
+        memcpy(keys, set->keys, set->length * sizeof(*keys));
+        zfree(set->keys);
+        set->keys = keys;
+    }
+    return set;
+}
+
+static int cmp_key(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+T fset_new(const unsigned long *keys, int n)
+{
+    T set;
+    int i, k;
+
+    assert(keys || n == 0);
+    assert(n >= 0);
+
+    set = alloc(n);
+    memcpy(set->keys, keys, n * sizeof(*keys));
+    qsort(set->keys, n, sizeof(*keys), cmp_key);
+    for (i = 0, k = 0; i < n; i++) {
+        if (k == 0 || set->keys[i] != set->keys[k-1]) {
+            set->keys[k++] = set->keys[i];
+        }
+    }
+    set->length = k;
+    return trim(set, n);
+}
+
+T set_freeze(set_t set, unsigned long key(const void *member))
+{
+    T frozen;
+    void **members;
+    unsigned long *keys;
+    int i, n;
+
+    assert(set);
+    n = set_length(set);
+    members = set_to_array(set, NULL);
+    keys = zalloc((n + 1) * sizeof(*keys));
+    for (i = 0; i < n; i++) {
+        keys[i] = key ? key(members[i]) : (unsigned long)members[i];
+    }
+    frozen = fset_new(keys, n);
+
+    zfree(keys);
+    zfree(members);
+    return frozen;
+}
+
+void fset_free(T *set)
+{
+    assert(set && *set);
+    zfree((*set)->keys);
+    zfree(*set);
+    *set = NULL;
+}
+
+int fset_length(T set)
+{
+    assert(set);
+    return set->length;
+}
+
+const unsigned long *fset_keys(T set)
+{
+    assert(set);
+    return set->keys;
+}
+
+/* the index of the first key >= x in a[lo..hi) */
+static int lower_bound(const unsigned long *a, int lo, int hi, unsigned long x)
+{
+    int mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (a[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* the index of the first key >= x in a[lo..n), searching from *lo* with
+ * doubling steps */
+static int gallop(const unsigned long *a, int lo, int n, unsigned long x)
+{
+    int step = 1;
+
+    while (lo + step < n && a[lo + step] < x) {
+        step *= 2;
+    }
+    return lower_bound(a, lo + step / 2, (lo + step < n) ? lo + step + 1 : n,
+                       x);
+}
+
+bool fset_member(T set, unsigned long key)
+{
+    int i;
+
+    assert(set);
+    i = lower_bound(set->keys, 0, set->length, key);
+    return i < set->length && set->keys[i] == key;
+}
+
+void fset_map(T set, void apply(unsigned long key, void *cl), void *cl)
+{
+    int i;
+
+    assert(set);
+    assert(apply);
+    for (i = 0; i < set->length; i++) {
+        apply(set->keys[i], cl);
+    }
+}
+
+#ifdef FSET_SSE2
+/* the 64-bit lanes of a and b that are equal */
+static inline __m128i eq64(__m128i a, __m128i b)
+{
+    __m128i e = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+/* the lanes of a found among the four keys of b0 and b1 */
+static inline int match(__m128i a, __m128i b0, __m128i b1)
+{
+    __m128i s0 = _mm_shuffle_epi32(b0, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i s1 = _mm_shuffle_epi32(b1, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i m = _mm_or_si128(_mm_or_si128(eq64(a, b0), eq64(a, s0)),
+                             _mm_or_si128(eq64(a, b1), eq64(a, s1)));
+    return _mm_movemask_pd(_mm_castsi128_pd(m));
+}
+
+/* intersect blocks of four keys, every key of a block of a is compared with
+ * every key of a block of b, and the block with the smaller last key moves
+ * on. Return the number of keys written to *out*, *i* and *j* are where
+ * the scalar merge resumes */
+static int inter_blocks(const unsigned long *a, int na,
+                        const unsigned long *b, int nb,
+                        unsigned long *out, int *i, int *j)
+{
+    int k = 0, mask;
+    unsigned long amax, bmax;
+
+    while (*i + 4 <= na && *j + 4 <= nb) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(b + *j));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(b + *j + 2));
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(a + *i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(a + *i + 2));
+
+        mask = match(a0, b0, b1) | match(a1, b0, b1) << 2;
+        while (mask) {
+            out[k++] = a[*i + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+        amax = a[*i + 3];
+        bmax = b[*j + 3];
+        *i += (amax <= bmax) ? 4 : 0;
+        *j += (bmax <= amax) ? 4 : 0;
+    }
+    return k;
+}
+#endif
+
+T fset_inter(T s, T t)
+{
+    const unsigned long *a, *b;
+    unsigned long *out, x, y;
+    int na, nb, i = 0, j = 0, k = 0;
+    T set;
+
+    assert(s && t);
+    if (s->length > t->length) {
+        return fset_inter(t, s);
+    }
+    a = s->keys;
+    na = s->length;
+    b = t->keys;
+    nb = t->length;
+    set = alloc(na);
+    out = set->keys;
+
+    if ((long)na * GALLOP < nb) {
+        for (i = 0; i < na && j < nb; i++) {
+            j = gallop(b, j, nb, a[i]);
+            if (j < nb && b[j] == a[i]) {
+                out[k++] = a[i];
+            }
+        }
+        set->length = k;
+        return trim(set, na);
+    }
+
+#ifdef FSET_SSE2
+    k = inter_blocks(a, na, b, nb, out, &i, &j);
+#endif
+    /* no branch on the comparison, it is not predictable */
+    while (i < na && j < nb) {
+        x = a[i];
+        y = b[j];
+        out[k] = x;
+        k += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    set->length = k;
+    return trim(set, na);
+}
+
+T fset_union(T s, T t)
+{
+    const unsigned long *a, *b;
+    unsigned long *out, x, y;
+    int na, nb, i = 0, j = 0, k = 0;
+    T set;
+
+    assert(s && t);
+    a = s->keys;
+    na = s->length;
+    b = t->keys;
+    nb = t->length;
+    set = alloc(na + nb);
+    out = set->keys;
+
+    while (i < na && j < nb) {
+        x = a[i];
+        y = b[j];
+        out[k++] = (x < y) ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out + k, a + i, (na - i) * sizeof(*out));
+    k += na - i;
+    memcpy(out + k, b + j, (nb - j) * sizeof(*out));
+    k += nb - j;
+
+    set->length = k;
+    return trim(set, na + nb);
+}
+
+T fset_minus(T s, T t)
+{
+    const unsigned long *a, *b;
+    unsigned long *out, x, y;
+    int na, nb, i = 0, j = 0, k = 0;
+    T set;
+
+    assert(s && t);
+    a = s->keys;
+    na = s->length;
+    b = t->keys;
+    nb = t->length;
+    set = alloc(na);
+    out = set->keys;
+
+    if ((long)na * GALLOP < nb) {
+        for (i = 0; i < na; i++) {
+            j = gallop(b, j, nb, a[i]);
+            if (j == nb || b[j] != a[i]) {
+                out[k++] = a[i];
+            }
+        }
+        set->length = k;
+        return trim(set, na);
+    }
+
+    while (i < na && j < nb) {
+        x = a[i];
+        y = b[j];
+        out[k] = x;
+        k += x < y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out + k, a + i, (na - i) * sizeof(*out));
+    k += na - i;
+
+    set->length = k;
+    return trim(set, na);
+}
@@ -0,0 +1,52 @@
+/** @file fset.h
+ * @brief flat sets, immutable sorted arrays of keys.
+ *
+ * An fset holds distinct unsigned long keys, pointers or integers, in one
+ * sorted array. Membership is a binary search, and the set operations are
+ * merges that read both arrays once from start to end: *fset_inter* compares
+ * blocks of keys with SSE2 when available, and gallops through the larger
+ * set when the sizes are far apart.
+ *
+ * A hashed *set_t* can be frozen into an fset once it is built, keyed by its
+ * members or by keys extracted from them.
+ */
+#ifndef FSET_H
+#define FSET_H
+
+#include <stdbool.h>
+#include "set.h"
+
+#define T fset_t
+typedef struct T *T;
+
+/** @brief build a flat set from *n* keys, duplicates are dropped */
+extern T fset_new(const unsigned long *keys, int n);
+
+/** @brief build a flat set from the members of *set*
+ * @param key returns the key of a member, NULL to use the member pointers.
+ */
+extern T set_freeze(set_t set, unsigned long key(const void *member));
+
+/** @brief free a flat set */
+extern void fset_free(T *set);
+
+/** @brief return the number of keys */
+extern int fset_length(T set);
+
+/** @brief return the sorted keys, *fset_length* of them */
+extern const unsigned long *fset_keys(T set);
+
+/** @brief test if *key* is in *set* */
+extern bool fset_member(T set, unsigned long key);
+
+/** @brief apply a function over the keys in increasing order */
+extern void fset_map(T set, void apply(unsigned long key, void *cl), void *cl);
+
+/** @brief return a new set, the intersection, union or difference (keys of
+ * *s* not in *t*) of *s* and *t* */
+extern T fset_inter(T s, T t);
+extern T fset_union(T s, T t);
+extern T fset_minus(T s, T t);
+
+#undef T
+#endif /* end of include guard: FSET_H */
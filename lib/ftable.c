@@ -0,0 +1,322 @@
+/* implementation of *ftable*
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ftable.h"
+#include "mem.h"
+
+#define T ftable_t
+
+/* average number of keys per bucket, more means fewer displacements to
+ * store but a longer search for them */
+#define LAMBDA 4
+
+/* displacement of a bucket whose keys could not be placed, they are kept in
+ * *overflow* and searched linearly */
+#define OVERFLOW UINT32_MAX
+
+struct T {
+    int length;
+    int nbuckets;
+    int nslots;
+    int noverflow;
+    uint32_t *disp;         /* displacement of every bucket */
+    struct slot {
+        const void *key;
+        void *value;
+    } *slots, *overflow;
+    int (*cmp)(const void *a, const void *b);
+    unsigned (*hash)(const void *key);
+};
+
+static unsigned default_hash(const void *key)
+{
+    return (unsigned long)key >> 2;
+}
+
+static int default_cmp(const void *a, const void *b)
+{
+    return a != b;
+}
+
+/* derive a new hash from *h* and *seed* */
+static inline uint32_t mix(unsigned h, uint32_t seed)
+{
+    uint64_t x = ((uint64_t)h << 32 | seed) * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+/* map *x* onto [0, n) without a division */
+static inline uint32_t range(uint32_t x, int n)
+{
+    return ((uint64_t)x * (uint32_t)n) >> 32;
+}
+
+#define bucket_of(h, nbuckets) range(mix((h), 0x5bd1e995U), (nbuckets))
+#define slot_of(h, d, nslots)  range(mix((h), (d)), (nslots))
+
+/* key of the build, sorted by bucket then by hash */
+struct item {
+    uint32_t bucket;
+    unsigned hash;
+    int idx;
+};
+
+static int cmp_item(const void *a, const void *b)
+{
+    const struct item *x = a, *y = b;
+    if (x->bucket != y->bucket) {
+        return x->bucket < y->bucket ? -1 : 1;
+    }
+    if (x->hash != y->hash) {
+        return x->hash < y->hash ? -1 : 1;
+    }
+    return 0;
+}
+
+/* a bucket of the build, [start, start + size) in the items */
+struct group {
+    int start;
+    int size;
+};
+
+static int cmp_group(const void *a, const void *b)
+{
+    const struct group *x = a, *y = b;
+    return y->size - x->size;
+}
+
+/* can the keys of *g* go to slots of displacement *d*? the slots are stored
+ * in *slots*, and marked in *taken* if they can */
+static int try_place(T table, struct item *items, struct group *g, uint32_t d,
+                     unsigned char *taken, uint32_t *slots)
+{
+    int i, j;
+
+    for (i = 0; i < g->size; i++) {
+        slots[i] = slot_of(items[g->start + i].hash, d, table->nslots);
+        if (taken[slots[i]]) {
+            break;
+        }
+        for (j = 0; j < i && slots[j] != slots[i]; j++) {
+            /* pass */
+        }
+        if (j < i) {
+            break;
+        }
+    }
+    if (i < g->size) {
+        return 0;
+    }
+    for (i = 0; i < g->size; i++) {
+        taken[slots[i]] = 1;
+    }
+    return 1;
+}
+
+T ftable_new(void **pairs, int n,
+             int cmp(const void *a, const void *b),
+             unsigned hash(const void *key))
+{
+    T table;
+    struct item *items;
+    struct group *groups;
+    unsigned char *taken;
+    uint32_t *slots;
+    int i, j, ngroups, nduplicate, maxsize;
+    long bound;
+
+    assert(pairs || n == 0);
+    assert(n >= 0);
+
+    table = (T)zalloc(sizeof(*table));
+    table->cmp = cmp ? cmp : default_cmp;
+    table->hash = hash ? hash : default_hash;
+    table->length = n;
+    table->nbuckets = n / LAMBDA + 1;
+    table->disp = zcalloc(table->nbuckets, sizeof(table->disp[0]));
+
+    items = zalloc((n + 1) * sizeof(*items));
+    for (i = 0; i < n; i++) {
+        items[i].hash = (*table->hash)(pairs[2*i]);
+        items[i].bucket = bucket_of(items[i].hash, table->nbuckets);
+        items[i].idx = i;
+    }
+    qsort(items, n, sizeof(*items), cmp_item);
+
+    /* split into buckets, keys with the same hash can never be told apart
+     * by a displacement, their whole bucket goes to the overflow */
+    groups = zalloc((n + 1) * sizeof(*groups));
+    ngroups = 0;
+    nduplicate = 0;
+    maxsize = 0;
+    for (i = 0; i < n; i = j) {
+        int dup = 0;
+        for (j = i + 1; j < n && items[j].bucket == items[i].bucket; j++) {
+            dup |= items[j].hash == items[j-1].hash;
+        }
+        if (dup) {
+            table->disp[items[i].bucket] = OVERFLOW;
+            nduplicate += j - i;
+        } else {
+            groups[ngroups].start = i;
+            groups[ngroups].size = j - i;
+            maxsize = (j - i > maxsize) ? j - i : maxsize;
+            ngroups++;
+        }
+    }
+    qsort(groups, ngroups, sizeof(*groups), cmp_group);
+
+    table->nslots = n - nduplicate;
+    table->slots = zcalloc(table->nslots + 1, sizeof(table->slots[0]));
+    taken = zcalloc(table->nslots + 1, sizeof(*taken));
+    slots = zalloc((maxsize + 1) * sizeof(*slots));
+
+    /* place the biggest buckets first, while most slots are still free. The
+     * last buckets need about nslots/free tries, give up long after that */
+    bound = 64L * table->nslots + (1 << 16);
+    if (bound > (long)OVERFLOW) {
+        bound = OVERFLOW;
+    }
+    for (i = 0; i < ngroups; i++) {
+        struct group *g = &groups[i];
+        uint32_t b = items[g->start].bucket;
+        uint32_t d;
+
+        for (d = 0; d < (uint32_t)bound; d++) {
+            if (try_place(table, items, g, d, taken, slots)) {
+                break;
+            }
+        }
+        if (d < (uint32_t)bound) {
+            table->disp[b] = d;
+            for (j = 0; j < g->size; j++) {
+                int idx = items[g->start + j].idx;
+                table->slots[slots[j]].key = pairs[2*idx];
+                table->slots[slots[j]].value = pairs[2*idx+1];
+            }
+        } else {
+            /* never seen in practice, the slots of the bucket stay empty */
+            table->disp[b] = OVERFLOW;
+        }
+    }
+
+    /* fill the overflow */
+    for (i = 0, j = 0; i < n; i++) {
+        j += table->disp[items[i].bucket] == OVERFLOW;
+    }
+    table->overflow = zalloc((j + 1) * sizeof(table->overflow[0]));
+    table->noverflow = 0;
+    for (i = 0; i < n; i++) {
+        if (table->disp[items[i].bucket] == OVERFLOW) {
+            struct slot *s = &table->overflow[table->noverflow++];
+            s->key = pairs[2*items[i].idx];
+            s->value = pairs[2*items[i].idx+1];
+        }
+    }
+
+    zfree(slots);
+    zfree(taken);
+    zfree(groups);
+    zfree(items);
+    return table;
+}
+
+/* the closure of *table_freeze*, the pairs filled so far */
+struct pairs {
+    void **pairs;
+    int n;
+};
+
+static void add_pair(const void *key, void **value, void *cl)
+{
+    struct pairs *p = cl;
+    p->pairs[2*p->n] = (void *)key;
+    p->pairs[2*p->n+1] = *value;
+    p->n ++;
+}
+
+T table_freeze(table_t table)
+{
+    struct pairs p;
+    T frozen;
+
+    assert(table);
+    p.pairs = zalloc((2 * table_length(table) + 1) * sizeof(p.pairs[0]));
+    p.n = 0;
+    table_map(table, add_pair, &p);
+    frozen = ftable_new(p.pairs, p.n, table_cmp(table), table_hash(table));
+    zfree(p.pairs);
+
+    return frozen;
+}
+
+void ftable_free(T *table)
+{
+    assert(table && *table);
+    zfree((*table)->overflow);
+    zfree((*table)->slots);
+    zfree((*table)->disp);
+    zfree(*table);
+    *table = NULL;
+}
+
+int ftable_length(T table)
+{
+    assert(table);
+    return table->length;
+}
+
+void *ftable_get(T table, const void *key)
+{
+    unsigned h;
+    uint32_t d;
+    struct slot *s;
+    int i;
+
+    assert(table);
+    assert(key);
+
+    h = (*table->hash)(key);
+    d = table->disp[bucket_of(h, table->nbuckets)];
+    if (d != OVERFLOW) {
+        if (table->nslots == 0) {
+            return NULL;
+        }
+        s = &table->slots[slot_of(h, d, table->nslots)];
+        return (s->key && (*table->cmp)(key, s->key) == 0) ? s->value : NULL;
+    }
+
+    for (i = 0; i < table->noverflow; i++) {
+        s = &table->overflow[i];
+        if ((*table->cmp)(key, s->key) == 0) {
+            return s->value;
+        }
+    }
+    return NULL;
+}
+
+void ftable_map(T table,
+                void apply(const void *key, void *value, void *cl),
+                void *cl)
+{
+    int i;
+
+    assert(table);
+    assert(apply);
+
+    for (i = 0; i < table->nslots; i++) {
+        if (table->slots[i].key) {
+            apply(table->slots[i].key, table->slots[i].value, cl);
+        }
+    }
+    for (i = 0; i < table->noverflow; i++) {
+        apply(table->overflow[i].key, table->overflow[i].value, cl);
+    }
+}
@@ -0,0 +1,53 @@
+/** @file ftable.h
+ * @brief frozen tables, read-only tables built on a minimal perfect hash.
+ *
+ * Once a table is fully loaded it can be frozen into an ftable. Keys are
+ * placed with the CHD algorithm (compress, hash and displace): keys are
+ * grouped into small buckets and every bucket gets a displacement that sends
+ * its keys to distinct free slots, so n keys fill exactly n slots. A lookup
+ * costs one call of *hash*, a displacement, a slot and one call of *cmp*,
+ * there are no chains and no empty slots.
+ *
+ * An ftable does not own its keys and values, they are the ones stored in
+ * the original table.
+ */
+#ifndef FTABLE_H
+#define FTABLE_H
+
+#include "table.h"
+
+#define T ftable_t
+typedef struct T *T;
+
+/** @brief freeze the current bindings of *table*
+ * The frozen table uses the *cmp* and *hash* of *table*, which can be
+ * changed or freed afterwards.
+ * @return a new frozen table.
+ */
+extern T table_freeze(table_t table);
+
+/** @brief build a frozen table from *n* (key, value) pairs
+ * @param pairs pairs[2*i] is a key and pairs[2*i+1] its value, in the format
+ * of *table_to_array*. Keys should be distinct.
+ * @param cmp, hash same as *table_new*, NULL for the defaults.
+ */
+extern T ftable_new(void **pairs, int n,
+                    int cmp(const void *a, const void *b),
+                    unsigned hash(const void *key));
+
+/** @brief free a frozen table, keys and values are not touched */
+extern void ftable_free(T *table);
+
+/** @brief return the number of bindings */
+extern int ftable_length(T table);
+
+/** @brief return the value of *key*, NULL if not found */
+extern void *ftable_get(T table, const void *key);
+
+/** @brief apply a function over all bindings */
+extern void ftable_map(T table,
+                       void apply(const void *key, void *value, void *cl),
+                       void *cl);
+
+#undef T
+#endif /* end of include guard: FTABLE_H */
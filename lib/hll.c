@@ -0,0 +1,175 @@
+/* implementation of *hll*
+ */
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "hll.h"
+#include "mem.h"
+
+#define T hll_t
+
+#define MIN_PRECISION 4
+#define MAX_PRECISION 18
+
+/* bits per register and registers per word, the top bits of a word are
+ * unused */
+#define RBITS 6
+#define RMASK ((1UL << RBITS) - 1)
+#define BPW (8 * sizeof(unsigned long))
+#define RPW (BPW / RBITS)
+
+struct T {
+    int p;
+    int m;                  /* 2^p registers */
+    int nwords;
+    unsigned long *words;
+};
+
+/* the lowest bit of every register of a word */
+static inline unsigned long ones(void)
+{
+    unsigned long x = 0;
+    unsigned i;
+
+    for (i = 0; i < RPW; i++) {
+        x |= 1UL << (i * RBITS);
+    }
+    return x;
+}
+
+/* spread the 32 bits of *h* over 64 */
+static inline uint64_t mix(unsigned h)
+{
+    uint64_t x = (uint64_t)h * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 32;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+    return x;
+}
+
+#define get(hll, j) \
+    (((hll)->words[(j) / RPW] >> ((j) % RPW * RBITS)) & RMASK)
+
+T hll_new(double error)
+{
+    T hll;
+    int p;
+
+    assert(error > 0);
+
+    /* the smallest p with 1.04 / sqrt(2^p) <= error */
+    for (p = MIN_PRECISION; p < MAX_PRECISION; p++) {
+        if (1.04 / sqrt((double)(1 << p)) <= error) {
+            break;
+        }
+    }
+
+    hll = (T)zalloc(sizeof(*hll));
+    hll->p = p;
+    hll->m = 1 << p;
+    hll->nwords = (hll->m + RPW - 1) / RPW;
+    hll->words = zcalloc(hll->nwords, sizeof(hll->words[0]));
+    return hll;
+}
+
+void hll_free(T *hll)
+{
+    assert(hll && *hll);
+    zfree((*hll)->words);
+    zfree(*hll);
+    *hll = NULL;
+}
+
+int hll_precision(T hll)
+{
+    assert(hll);
+    return hll->p;
+}
+
+double hll_error(T hll)
+{
+    assert(hll);
+    return 1.04 / sqrt((double)hll->m);
+}
+
+void hll_add(T hll, unsigned hash)
+{
+    uint64_t x, w;
+    unsigned long rank, *word;
+    int j, shift;
+
+    assert(hll);
+
+    /* the top p bits pick the register, it keeps the largest position of
+     * the first one bit in the rest */
+    x = mix(hash);
+    j = x >> (64 - hll->p);
+    w = x << hll->p;
+    rank = w ? __builtin_clzll(w) + 1 : 64 - hll->p + 1;
+
+    word = &hll->words[j / RPW];
+    shift = j % RPW * RBITS;
+    if (rank > ((*word >> shift) & RMASK)) {
+        *word = (*word & ~(RMASK << shift)) | rank << shift;
+    }
+}
+
+double hll_count(T hll)
+{
+    double sum = 0, estimate, alpha;
+    int j, zeros = 0;
+    unsigned long r;
+
+    assert(hll);
+
+    for (j = 0; j < hll->m; j++) {
+        r = get(hll, j);
+        sum += ldexp(1.0, -(int)r);
+        zeros += r == 0;
+    }
+    switch (hll->m) {
+    case 16: alpha = 0.673; break;
+    case 32: alpha = 0.697; break;
+    case 64: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1 + 1.079 / hll->m); break;
+    }
+    estimate = alpha * hll->m * hll->m / sum;
+
+    /* few keys leave registers empty, counting them is more precise */
+    if (estimate <= 2.5 * hll->m && zeros > 0) {
+        estimate = hll->m * log((double)hll->m / zeros);
+    }
+    return estimate;
+}
+
+/* the larger of each register of *a* and *b*, ten at a time. The top bit of
+ * every register of (a | H) - (b & ~H) tells if the low bits of a are at
+ * least those of b, and no register borrows from the next one */
+static inline unsigned long max_word(unsigned long a, unsigned long b,
+                                     unsigned long h)
+{
+    unsigned long low = (a | h) - (b & ~h);
+    unsigned long ge = ((a & ~b) | (~(a ^ b) & low)) & h;
+    unsigned long mask = (ge >> (RBITS - 1)) * RMASK;
+    return (a & mask) | (b & ~mask);
+}
+
+void hll_merge(T dst, T src)
+{
+    unsigned long h = ones() << (RBITS - 1);
+    int i;
+
+    assert(dst && src);
+    assert(dst->p == src->p);
+
+    for (i = 0; i < dst->nwords; i++) {
+        dst->words[i] = max_word(dst->words[i], src->words[i], h);
+    }
+}
+
+long hll_memory_usage(T hll)
+{
+    assert(hll);
+    return sizeof(*hll) + hll->nwords * sizeof(hll->words[0]);
+}
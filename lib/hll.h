@@ -0,0 +1,47 @@
+/** @file hll.h
+ * @brief HyperLogLog sketches, to count the distinct keys of a stream.
+ *
+ * A sketch of precision p has m = 2^p registers of 6 bits, packed ten to
+ * an unsigned long, and estimates the number of distinct keys added to it
+ * with a relative standard error of about 1.04 / sqrt(m). Its size depends
+ * only on p, never on the number of keys.
+ *
+ * Keys are added by their 32-bit hash, so keys with the same hash count
+ * once. Sketches of the same precision can be merged, e.g. one per thread
+ * merged at the end; the merge takes the maximum of ten registers at once.
+ */
+#ifndef HLL_H
+#define HLL_H
+
+#define T hll_t
+typedef struct T *T;
+
+/** @brief create an empty sketch with a relative standard error of at most
+ * *error*. The precision is kept between 4 and 18, i.e. an error between
+ * 26% and 0.2%, and 16 bytes to 205 KB of registers */
+extern T hll_new(double error);
+
+/** @brief free a sketch */
+extern void hll_free(T *hll);
+
+/** @brief return the precision p, the sketch has 2^p registers */
+extern int hll_precision(T hll);
+
+/** @brief return the relative standard error of the estimates */
+extern double hll_error(T hll);
+
+/** @brief add the key of hash *hash* */
+extern void hll_add(T hll, unsigned hash);
+
+/** @brief return the estimated number of distinct keys */
+extern double hll_count(T hll);
+
+/** @brief make *dst* the sketch of the keys of *dst* and *src*, both of the
+ * same precision */
+extern void hll_merge(T dst, T src);
+
+/** @brief return the number of bytes used by the sketch */
+extern long hll_memory_usage(T hll);
+
+#undef T
+#endif /* end of include guard: HLL_H */
@@ -0,0 +1,753 @@
+/* implementation of *iset*
+ */
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "iset.h"
+#include "mem.h"
+
+#define T iset_t
+
+/* an array container holds at most ARRAY_MAX values; a bitmap turns back
+ * into an array below ARRAY_MAX / 2, so that adding and removing around the
+ * limit does not convert every time */
+#define ARRAY_MAX 4096
+/* a bitmap has WORDS 64-bit words, 8 KB; a run list of more than RUN_MAX
+ * runs would be larger */
+#define WORDS 1024
+#define RUN_MAX 2048
+
+enum { ARRAY, BITMAP, RUN };
+
+struct run {
+    uint16_t start;
+    uint16_t last;
+};
+
+struct chunk {
+    uint16_t key;           /* the high 16 bits of the members */
+    uint8_t type;
+    int card;               /* number of members */
+    int n;                  /* values of an array, runs of a run list */
+    int cap;                /* values or runs allocated */
+    union {
+        uint16_t *array;
+        uint64_t *bitmap;
+        struct run *runs;
+    } u;
+};
+
+struct T {
+    unsigned long length;   /* up to 2^32 members */
+    int nchunks;
+    int cap;
+    struct chunk *chunks;   /* sorted by key */
+};
+
+/***********************************************************************
+ * containers
+ ***********************************************************************/
+
+/* the index of the first value >= x in a[0..n) */
+static int lower_bound(const uint16_t *a, int n, uint16_t x)
+{
+    int lo = 0, hi = n, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (a[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* the index of the last run starting at or before x, -1 if none */
+static int find_run(const struct run *runs, int n, uint16_t x)
+{
+    int lo = 0, hi = n, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (runs[mid].start <= x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
+
+/* make room for *n* elements of *size* bytes in *p*, which holds *used* of
+ * them in *cap* */
+static void *grow(void *p, int used, int *cap, int n, size_t size)
+{
+    void *q;
+
+    if (n <= *cap) {
+        return p;
+    }
+    *cap = (*cap * 2 > n) ? *cap * 2 : n;
+    q = zalloc(*cap * size);
+    memcpy(q, p, used * size);
+    zfree(p);
+    return q;
+}
+
+static void release(struct chunk *c)
+{
+    zfree(c->u.array);
+    c->u.array = NULL;
+}
+
+/* the number of runs of the sorted values v[0..n) */
+static int count_runs(const uint16_t *v, int n)
+{
+    int i, runs = n > 0;
+
+    for (i = 1; i < n; i++) {
+        runs += v[i] != v[i-1] + 1;
+    }
+    return runs;
+}
+
+/* store the sorted members of *c* in *out* */
+static void chunk_values(const struct chunk *c, uint16_t *out)
+{
+    int i, j = 0, v;
+    uint64_t word;
+
+    switch (c->type) {
+    case ARRAY:
+        memcpy(out, c->u.array, c->n * sizeof(*out));
+        break;
+    case BITMAP:
+        for (i = 0; i < WORDS; i++) {
+            for (word = c->u.bitmap[i]; word; word &= word - 1) {
+                out[j++] = i * 64 + __builtin_ctzll(word);
+            }
+        }
+        break;
+    default:
+        for (i = 0; i < c->n; i++) {
+            for (v = c->u.runs[i].start; v <= c->u.runs[i].last; v++) {
+                out[j++] = v;
+            }
+        }
+        break;
+    }
+}
+
+/* set up *c* as a container of *type* holding the sorted values
+ * v[0..card) */
+static void fill(struct chunk *c, int type, const uint16_t *v, int card)
+{
+    int i;
+
+    c->type = type;
+    c->card = card;
+    switch (type) {
+    case ARRAY:
+        c->n = card;
+        c->cap = card > 0 ? card : 1;
+        c->u.array = zalloc(c->cap * sizeof(c->u.array[0]));
+        memcpy(c->u.array, v, card * sizeof(v[0]));
+        break;
+    case BITMAP:
+        c->n = c->cap = 0;
+        c->u.bitmap = zcalloc(WORDS, sizeof(c->u.bitmap[0]));
+        for (i = 0; i < card; i++) {
+            c->u.bitmap[v[i] >> 6] |= (uint64_t)1 << (v[i] & 63);
+        }
+        break;
+    default:
+        c->n = 0;
+        c->cap = count_runs(v, card);
+        c->cap = c->cap > 0 ? c->cap : 1;
+        c->u.runs = zalloc(c->cap * sizeof(c->u.runs[0]));
+        for (i = 0; i < card; i++) {
+            if (i > 0 && v[i] == v[i-1] + 1) {
+                c->u.runs[c->n - 1].last = v[i];
+            } else {
+                c->u.runs[c->n].start = c->u.runs[c->n].last = v[i];
+                c->n ++;
+            }
+        }
+        break;
+    }
+}
+
+/* rebuild *c* as a container of *type* */
+static void convert(struct chunk *c, int type)
+{
+    uint16_t *v = zalloc((c->card + 1) * sizeof(*v));
+
+    chunk_values(c, v);
+    release(c);
+    fill(c, type, v, c->card);
+    zfree(v);
+}
+
+static bool chunk_member(const struct chunk *c, uint16_t x)
+{
+    int i;
+
+    switch (c->type) {
+    case ARRAY:
+        i = lower_bound(c->u.array, c->n, x);
+        return i < c->n && c->u.array[i] == x;
+    case BITMAP:
+        return (c->u.bitmap[x >> 6] >> (x & 63)) & 1;
+    default:
+        i = find_run(c->u.runs, c->n, x);
+        return i >= 0 && x <= c->u.runs[i].last;
+    }
+}
+
+/* add *x* to *c*, return true if it is new */
+static bool chunk_add(struct chunk *c, uint16_t x)
+{
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    struct run *r;
+    bool left, right;
+    int i;
+
+    switch (c->type) {
+    case ARRAY:
+        i = lower_bound(c->u.array, c->n, x);
+        if (i < c->n && c->u.array[i] == x) {
+            return false;
+        }
+        if (c->n == ARRAY_MAX) {
+            convert(c, BITMAP);
+            return chunk_add(c, x);
+        }
+        c->u.array = grow(c->u.array, c->n, &c->cap, c->n + 1,
+                          sizeof(c->u.array[0]));
+        memmove(c->u.array + i + 1, c->u.array + i,
+                (c->n - i) * sizeof(c->u.array[0]));
+        c->u.array[i] = x;
+        c->n ++;
+        break;
+    case BITMAP:
+        if (c->u.bitmap[x >> 6] & bit) {
+            return false;
+        }
+        c->u.bitmap[x >> 6] |= bit;
+        break;
+    default:
+        r = c->u.runs;
+        i = find_run(r, c->n, x);
+        if (i >= 0 && x <= r[i].last) {
+            return false;
+        }
+        /* x may extend run i, run i+1 or join both */
+        left = i >= 0 && r[i].last + 1 == x;
+        right = i + 1 < c->n && x + 1 == r[i+1].start;
+        if (left && right) {
+            r[i].last = r[i+1].last;
+            memmove(r + i + 1, r + i + 2, (c->n - i - 2) * sizeof(*r));
+            c->n --;
+        } else if (left) {
+            r[i].last = x;
+        } else if (right) {
+            r[i+1].start = x;
+        } else if (c->n == RUN_MAX) {
+            convert(c, BITMAP);
+            return chunk_add(c, x);
+        } else {
+            r = c->u.runs = grow(r, c->n, &c->cap, c->n + 1, sizeof(*r));
+            memmove(r + i + 2, r + i + 1, (c->n - i - 1) * sizeof(*r));
+            r[i+1].start = r[i+1].last = x;
+            c->n ++;
+        }
+        break;
+    }
+    c->card ++;
+    return true;
+}
+
+/* remove *x* from *c*, return true if it was there */
+static bool chunk_remove(struct chunk *c, uint16_t x)
+{
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    struct run *r;
+    int i;
+
+    switch (c->type) {
+    case ARRAY:
+        i = lower_bound(c->u.array, c->n, x);
+        if (i == c->n || c->u.array[i] != x) {
+            return false;
+        }
+        memmove(c->u.array + i, c->u.array + i + 1,
+                (c->n - i - 1) * sizeof(c->u.array[0]));
+        c->n --;
+        c->card --;
+        break;
+    case BITMAP:
+        if (!(c->u.bitmap[x >> 6] & bit)) {
+            return false;
+        }
+        c->u.bitmap[x >> 6] &= ~bit;
+        c->card --;
+        if (c->card < ARRAY_MAX / 2) {
+            convert(c, ARRAY);
+        }
+        break;
+    default:
+        r = c->u.runs;
+        i = find_run(r, c->n, x);
+        if (i < 0 || x > r[i].last) {
+            return false;
+        }
+        if (r[i].start == r[i].last) {
+            memmove(r + i, r + i + 1, (c->n - i - 1) * sizeof(*r));
+            c->n --;
+        } else if (x == r[i].start) {
+            r[i].start ++;
+        } else if (x == r[i].last) {
+            r[i].last --;
+        } else if (c->n == RUN_MAX) {
+            convert(c, BITMAP);
+            return chunk_remove(c, x);
+        } else {
+            /* split run i around x */
+            r = c->u.runs = grow(r, c->n, &c->cap, c->n + 1, sizeof(*r));
+            memmove(r + i + 2, r + i + 1, (c->n - i - 1) * sizeof(*r));
+            r[i+1].start = x + 1;
+            r[i+1].last = r[i].last;
+            r[i].last = x - 1;
+            c->n ++;
+        }
+        c->card --;
+        break;
+    }
+    return true;
+}
+
+static void chunk_map(const struct chunk *c,
+                      void apply(unsigned x, void *cl), void *cl)
+{
+    unsigned high = (unsigned)c->key << 16;
+    uint64_t word;
+    int i, v;
+
+    switch (c->type) {
+    case ARRAY:
+        for (i = 0; i < c->n; i++) {
+            apply(high | c->u.array[i], cl);
+        }
+        break;
+    case BITMAP:
+        for (i = 0; i < WORDS; i++) {
+            for (word = c->u.bitmap[i]; word; word &= word - 1) {
+                apply(high | (i * 64 + __builtin_ctzll(word)), cl);
+            }
+        }
+        break;
+    default:
+        for (i = 0; i < c->n; i++) {
+            for (v = c->u.runs[i].start; v <= c->u.runs[i].last; v++) {
+                apply(high | v, cl);
+            }
+        }
+        break;
+    }
+}
+
+static long chunk_bytes(const struct chunk *c)
+{
+    switch (c->type) {
+    case ARRAY:
+        return (long)c->cap * sizeof(c->u.array[0]);
+    case BITMAP:
+        return WORDS * sizeof(c->u.bitmap[0]);
+    default:
+        return (long)c->cap * sizeof(c->u.runs[0]);
+    }
+}
+
+static void clone(struct chunk *out, const struct chunk *c)
+{
+    size_t size = chunk_bytes(c);
+
+    *out = *c;
+    out->u.array = zalloc(size);
+    memcpy(out->u.array, c->u.array, size);
+}
+
+/* store the members of *c* in the bitmap *words* */
+static void load_bitmap(const struct chunk *c, uint64_t *words)
+{
+    int i, v;
+
+    if (c->type == BITMAP) {
+        memcpy(words, c->u.bitmap, WORDS * sizeof(*words));
+        return;
+    }
+    memset(words, 0, WORDS * sizeof(*words));
+    if (c->type == ARRAY) {
+        for (i = 0; i < c->n; i++) {
+            words[c->u.array[i] >> 6] |= (uint64_t)1 << (c->u.array[i] & 63);
+        }
+    } else {
+        for (i = 0; i < c->n; i++) {
+            for (v = c->u.runs[i].start; v <= c->u.runs[i].last; v++) {
+                words[v >> 6] |= (uint64_t)1 << (v & 63);
+            }
+        }
+    }
+}
+
+/* make *c* the owner of the bitmap *words*, turned into an array if it has
+ * few members */
+static void take_bitmap(struct chunk *c, uint64_t *words)
+{
+    int i;
+
+    c->type = BITMAP;
+    c->u.bitmap = words;
+    c->n = c->cap = 0;
+    c->card = 0;
+    for (i = 0; i < WORDS; i++) {
+        c->card += __builtin_popcountll(words[i]);
+    }
+    if (c->card <= ARRAY_MAX) {
+        convert(c, ARRAY);
+    }
+}
+
+/* the union of two chunks with the same key */
+static void chunk_union(struct chunk *out, const struct chunk *a,
+                        const struct chunk *b)
+{
+    uint64_t *w, *v;
+    int i, j, k;
+
+    out->key = a->key;
+    if (a->type == ARRAY && b->type == ARRAY
+            && a->card + b->card <= ARRAY_MAX) {
+        uint16_t *x = a->u.array, *y = b->u.array;
+        out->type = ARRAY;
+        out->cap = a->n + b->n;
+        out->u.array = zalloc(out->cap * sizeof(out->u.array[0]));
+        for (i = j = k = 0; i < a->n && j < b->n; ) {
+            if (x[i] < y[j]) {
+                out->u.array[k++] = x[i++];
+            } else if (x[i] > y[j]) {
+                out->u.array[k++] = y[j++];
+            } else {
+                out->u.array[k++] = x[i++];
+                j++;
+            }
+        }
+        while (i < a->n) {
+            out->u.array[k++] = x[i++];
+        }
+        while (j < b->n) {
+            out->u.array[k++] = y[j++];
+        }
+        out->n = out->card = k;
+        return;
+    }
+
+    /* word by word, a loop the compiler vectorizes */
+    w = zalloc(WORDS * sizeof(*w));
+    v = zalloc(WORDS * sizeof(*v));
+    load_bitmap(a, w);
+    load_bitmap(b, v);
+    for (i = 0; i < WORDS; i++) {
+        w[i] |= v[i];
+    }
+    zfree(v);
+    take_bitmap(out, w);
+}
+
+/* the intersection of two chunks with the same key, possibly empty */
+static void chunk_inter(struct chunk *out, const struct chunk *a,
+                        const struct chunk *b)
+{
+    uint64_t *w, *v;
+    int i, j, k;
+
+    out->key = a->key;
+    if (a->type == ARRAY && b->type == ARRAY) {
+        uint16_t *x = a->u.array, *y = b->u.array;
+        out->type = ARRAY;
+        out->cap = (a->n < b->n ? a->n : b->n) + 1;
+        out->u.array = zalloc(out->cap * sizeof(out->u.array[0]));
+        for (i = j = k = 0; i < a->n && j < b->n; ) {
+            if (x[i] < y[j]) {
+                i++;
+            } else if (x[i] > y[j]) {
+                j++;
+            } else {
+                out->u.array[k++] = x[i++];
+                j++;
+            }
+        }
+        out->n = out->card = k;
+        return;
+    }
+    if (a->type == ARRAY || b->type == ARRAY) {
+        const struct chunk *arr = (a->type == ARRAY) ? a : b;
+        const struct chunk *other = (arr == a) ? b : a;
+        out->type = ARRAY;
+        out->cap = arr->n + 1;
+        out->u.array = zalloc(out->cap * sizeof(out->u.array[0]));
+        for (i = k = 0; i < arr->n; i++) {
+            if (chunk_member(other, arr->u.array[i])) {
+                out->u.array[k++] = arr->u.array[i];
+            }
+        }
+        out->n = out->card = k;
+        return;
+    }
+
+    w = zalloc(WORDS * sizeof(*w));
+    v = zalloc(WORDS * sizeof(*v));
+    load_bitmap(a, w);
+    load_bitmap(b, v);
+    for (i = 0; i < WORDS; i++) {
+        w[i] &= v[i];
+    }
+    zfree(v);
+    take_bitmap(out, w);
+}
+
+/***********************************************************************
+ * sets
+ ***********************************************************************/
+
+/* the index of the chunk of *key*, or -(where it would go) - 1 */
+static int find_chunk(T set, uint16_t key)
+{
+    int lo = 0, hi = set->nchunks, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (set->chunks[mid].key < key) {
+            lo = mid + 1;
+        } else if (set->chunks[mid].key > key) {
+            hi = mid;
+        } else {
+            return mid;
+        }
+    }
+    return -lo - 1;
+}
+
+static T new_set(int nchunks)
+{
+    T set = (T)zalloc(sizeof(*set));
+
+    set->length = 0;
+    set->nchunks = 0;
+    set->cap = nchunks > 0 ? nchunks : 1;
+    set->chunks = zalloc(set->cap * sizeof(set->chunks[0]));
+    return set;
+}
+
+T iset_new(void)
+{
+    return new_set(4);
+}
+
+void iset_free(T *set)
+{
+    int i;
+
+    assert(set && *set);
+    for (i = 0; i < (*set)->nchunks; i++) {
+        release(&(*set)->chunks[i]);
+    }
+    zfree((*set)->chunks);
+    zfree(*set);
+    *set = NULL;
+}
+
+unsigned long iset_length(T set)
+{
+    assert(set);
+    return set->length;
+}
+
+bool iset_member(T set, unsigned x)
+{
+    int i;
+
+    assert(set);
+    i = find_chunk(set, x >> 16);
+    return i >= 0 && chunk_member(&set->chunks[i], x & 0xffff);
+}
+
+void iset_put(T set, unsigned x)
+{
+    struct chunk *c;
+    int i;
+
+    assert(set);
+    i = find_chunk(set, x >> 16);
+    if (i < 0) {
+        i = -i - 1;
+        set->chunks = grow(set->chunks, set->nchunks, &set->cap,
+                           set->nchunks + 1, sizeof(set->chunks[0]));
+        memmove(set->chunks + i + 1, set->chunks + i,
+                (set->nchunks - i) * sizeof(set->chunks[0]));
+        set->nchunks ++;
+
+        c = &set->chunks[i];
+        c->key = x >> 16;
+        c->type = ARRAY;
+        c->card = c->n = 0;
+        c->cap = 4;
+        c->u.array = zalloc(c->cap * sizeof(c->u.array[0]));
+    }
+    if (chunk_add(&set->chunks[i], x & 0xffff)) {
+        set->length ++;
+    }
+}
+
+bool iset_remove(T set, unsigned x)
+{
+    int i;
+
+    assert(set);
+    i = find_chunk(set, x >> 16);
+    if (i < 0 || !chunk_remove(&set->chunks[i], x & 0xffff)) {
+        return false;
+    }
+    set->length --;
+    if (set->chunks[i].card == 0) {
+        release(&set->chunks[i]);
+        memmove(set->chunks + i, set->chunks + i + 1,
+                (set->nchunks - i - 1) * sizeof(set->chunks[0]));
+        set->nchunks --;
+    }
+    return true;
+}
+
+void iset_map(T set, void apply(unsigned x, void *cl), void *cl)
+{
+    int i;
+
+    assert(set);
+    assert(apply);
+    for (i = 0; i < set->nchunks; i++) {
+        chunk_map(&set->chunks[i], apply, cl);
+    }
+}
+
+/* the next free place of iset_to_array */
+static void append(unsigned x, void *cl)
+{
+    unsigned **p = cl;
+    *(*p)++ = x;
+}
+
+unsigned *iset_to_array(T set)
+{
+    unsigned *array, *p;
+
+    assert(set);
+    p = array = zalloc((size_t)(set->length + 1) * sizeof(*array));
+    iset_map(set, append, &p);
+    return array;
+}
+
+void iset_optimize(T set)
+{
+    struct chunk *c;
+    uint16_t *v;
+    long array, runs, bitmap = WORDS * sizeof(uint64_t);
+    int i, type;
+
+    assert(set);
+    v = zalloc(WORDS * 64 * sizeof(*v));
+    for (i = 0; i < set->nchunks; i++) {
+        c = &set->chunks[i];
+        chunk_values(c, v);
+        array = (c->card <= ARRAY_MAX) ? c->card * (long)sizeof(v[0])
+                                       : bitmap + 1;
+        runs = count_runs(v, c->card) * (long)sizeof(struct run);
+
+        if (runs < array && runs < bitmap) {
+            type = RUN;
+        } else {
+            type = (array <= bitmap) ? ARRAY : BITMAP;
+        }
+        /* also trims the spare room of arrays and run lists */
+        if (type != BITMAP || c->type != BITMAP) {
+            release(c);
+            fill(c, type, v, c->card);
+        }
+    }
+    zfree(v);
+}
+
+long iset_memory_usage(T set)
+{
+    long bytes;
+    int i;
+
+    assert(set);
+    bytes = sizeof(*set) + (long)set->cap * sizeof(set->chunks[0]);
+    for (i = 0; i < set->nchunks; i++) {
+        bytes += chunk_bytes(&set->chunks[i]);
+    }
+    return bytes;
+}
+
+T iset_union(T s, T t)
+{
+    T set;
+    struct chunk *c;
+    int i, j;
+
+    assert(s && t);
+    set = new_set(s->nchunks + t->nchunks);
+    for (i = j = 0; i < s->nchunks || j < t->nchunks; ) {
+        c = &set->chunks[set->nchunks++];
+        if (j == t->nchunks
+                || (i < s->nchunks && s->chunks[i].key < t->chunks[j].key)) {
+            clone(c, &s->chunks[i++]);
+        } else if (i == s->nchunks || s->chunks[i].key > t->chunks[j].key) {
+            clone(c, &t->chunks[j++]);
+        } else {
+            chunk_union(c, &s->chunks[i++], &t->chunks[j++]);
+        }
+        set->length += c->card;
+    }
+    return set;
+}
+
+T iset_inter(T s, T t)
+{
+    T set;
+    struct chunk *c;
+    int i, j;
+
+    assert(s && t);
+    set = new_set(s->nchunks < t->nchunks ? s->nchunks : t->nchunks);
+    for (i = j = 0; i < s->nchunks && j < t->nchunks; ) {
+        if (s->chunks[i].key < t->chunks[j].key) {
+            i++;
+        } else if (s->chunks[i].key > t->chunks[j].key) {
+            j++;
+        } else {
+            c = &set->chunks[set->nchunks];
+            chunk_inter(c, &s->chunks[i++], &t->chunks[j++]);
+            if (c->card == 0) {
+                release(c);
+            } else {
+                set->length += c->card;
+                set->nchunks ++;
+            }
+        }
+    }
+    return set;
+}
@@ -0,0 +1,66 @@
+/** @file iset.h
+ * @brief compressed sets of 32-bit unsigned integers.
+ *
+ * iset splits its members by their high 16 bits into chunks of 65536
+ * values, in the way of Roaring bitmaps. A chunk holds its low 16 bits in
+ * one of three containers:
+ *
+ * - an array of sorted values, while it has at most 4096 members;
+ * - a bitmap of 65536 bits, once it has more;
+ * - a list of runs [start, last], made by *iset_optimize* when that is
+ *   the smallest.
+ *
+ * Dense sets take from one bit per member (bitmaps) down to a few bytes per
+ * run of consecutive members, sparse ones two bytes per member. Members are
+ * always visited in increasing order.
+ */
+#ifndef ISET_H
+#define ISET_H
+
+#include <stdbool.h>
+
+#define T iset_t
+typedef struct T *T;
+
+/** @brief create a new, empty set */
+extern T iset_new(void);
+
+/** @brief free a set */
+extern void iset_free(T *set);
+
+/** @brief return the number of members, up to 2^32 */
+extern unsigned long iset_length(T set);
+
+/** @brief test if *x* is a member of *set* */
+extern bool iset_member(T set, unsigned x);
+
+/** @brief add *x* to *set* */
+extern void iset_put(T set, unsigned x);
+
+/** @brief remove *x* from *set*
+ * @return true if *x* was a member.
+ */
+extern bool iset_remove(T set, unsigned x);
+
+/** @brief apply a function over the members in increasing order, the set
+ * should not change while mapping */
+extern void iset_map(T set, void apply(unsigned x, void *cl), void *cl);
+
+/** @brief return the members in increasing order, in an array of
+ * *iset_length* elements to be freed with *zfree* */
+extern unsigned *iset_to_array(T set);
+
+/** @brief convert every chunk to its smallest container, runs included.
+ * Useful once a set is fully built.
+ */
+extern void iset_optimize(T set);
+
+/** @brief return the number of bytes used by the set */
+extern long iset_memory_usage(T set);
+
+/** @brief return a new set, the union or the intersection of *s* and *t* */
+extern T iset_union(T s, T t);
+extern T iset_inter(T s, T t);
+
+#undef T
+#endif /* end of include guard: ISET_H */
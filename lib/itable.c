@@ -0,0 +1,175 @@
+/* implementation of *itable*
+ */
+#include <limits.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "itable.h"
+#include "mem.h"
+
+#define T itable_t
+
+struct T {
+    int size;               /* number of slots, a power of two */
+    int length;
+    unsigned timestamp;     /* used in itable_map to indicate that table
+                               should not change while doing *map* */
+    struct slot {
+        unsigned long key;
+        void *value;        /* NULL if the slot is empty */
+    } *slots;
+};
+
+/* the finalizer of splitmix64, small keys are spread over all bits */
+static inline unsigned long mix(unsigned long key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9UL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebUL;
+    key ^= key >> 31;
+    return key;
+}
+
+#define home(table, key) (mix(key) & ((table)->size - 1))
+#define next(table, i) (((i) + 1) & ((table)->size - 1))
+
+T itable_new(int hint)
+{
+    T table;
+
+    assert(hint >= 0);
+    table = (T)zalloc(sizeof(*table));
+    for (table->size = 16; table->size < 2 * hint && table->size < INT_MAX/2;
+            table->size <<= 1) {
+        /* pass */
+    }
+    table->slots = zcalloc(table->size, sizeof(table->slots[0]));
+    table->length = 0;
+    table->timestamp = 0;
+
+    return table;
+}
+
+void itable_free(T *table)
+{
+    assert(table && *table);
+    zfree((*table)->slots);
+    zfree(*table);
+    *table = NULL;
+}
+
+int itable_length(T table)
+{
+    assert(table);
+    return table->length;
+}
+
+/* return the slot of *key*, or the empty slot that ends its probe */
+static inline struct slot *lookup(T table, unsigned long key)
+{
+    unsigned long i;
+    struct slot *s;
+
+    for (i = home(table, key); ; i = next(table, i)) {
+        s = &table->slots[i];
+        if (s->value == NULL || s->key == key) {
+            return s;
+        }
+    }
+}
+
+void *itable_get(T table, unsigned long key)
+{
+    assert(table);
+    return lookup(table, key)->value;
+}
+
+static void grow(T table)
+{
+    struct slot *old = table->slots;
+    int i, size = table->size;
+
+    table->size <<= 1;
+    table->slots = zcalloc(table->size, sizeof(table->slots[0]));
+    for (i = 0; i < size; i++) {
+        if (old[i].value) {
+            *lookup(table, old[i].key) = old[i];
+        }
+    }
+    zfree(old);
+}
+
+void *itable_put(T table, unsigned long key, void *value)
+{
+    struct slot *s;
+    void *prev;
+
+    assert(table);
+    assert(value);
+
+    s = lookup(table, key);
+    prev = s->value;
+    s->key = key;
+    s->value = value;
+    table->timestamp ++;
+
+    if (prev == NULL && ++table->length > table->size / 2) {
+        grow(table);
+    }
+    return prev;
+}
+
+void *itable_remove(T table, unsigned long key)
+{
+    struct slot *s;
+    unsigned long i, j, h;
+    void *value;
+
+    assert(table);
+
+    s = lookup(table, key);
+    value = s->value;
+    if (value == NULL) {
+        return NULL;
+    }
+    table->length --;
+    table->timestamp ++;
+
+    /* backward shift: move later entries of the cluster into the hole when
+     * the hole lies on their probe path, so no tombstone is needed */
+    i = s - table->slots;
+    for (j = next(table, i); table->slots[j].value; j = next(table, j)) {
+        h = home(table, table->slots[j].key);
+        /* keep j if its home is cyclically in (i, j] */
+        if ((i < j) ? (i < h && h <= j) : (i < h || h <= j)) {
+            continue;
+        }
+        table->slots[i] = table->slots[j];
+        i = j;
+    }
+    table->slots[i].value = NULL;
+
+    return value;
+}
+
+void itable_map(T table,
+                void apply(unsigned long key, void **value, void *cl),
+                void *cl)
+{
+    int i;
+    unsigned timestamp;
+
+    assert(table);
+    assert(apply);
+    timestamp = table->timestamp;
+
+    for (i = 0; i < table->size; i++) {
+        if (table->slots[i].value) {
+            apply(table->slots[i].key, &table->slots[i].value, cl);
+            assert(table->timestamp == timestamp);
+            assert(table->slots[i].value);
+        }
+    }
+    (void)timestamp;
+}
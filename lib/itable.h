@@ -0,0 +1,50 @@
+/** @file itable.h
+ * @brief a table keyed by integers.
+ *
+ * itable is a table whose keys are integers, or pointers cast to
+ * unsigned long, compared by value. Keys are stored in the slots themselves
+ * and hashed with an inlined mixing function, no *cmp* or *hash* function is
+ * called. Collisions are resolved by linear probing in a power-of-two slot
+ * array that is kept at most half full.
+ *
+ * Values can not be NULL, NULL marks an empty slot.
+ */
+#ifndef ITABLE_H
+#define ITABLE_H
+
+#define T itable_t
+typedef struct T *T;
+
+/** @brief create a new table
+ * @param hint the estimated number of entries.
+ * @return a new table.
+ */
+extern T itable_new(int hint);
+
+/** @brief free a table, the values are not touched */
+extern void itable_free(T *table);
+
+/** @brief return the number of bindings */
+extern int itable_length(T table);
+
+/** @brief bind *value* to *key*, *value* should not be NULL.
+ * @return the previous value, NULL if *key* was not in the table.
+ */
+extern void *itable_put(T table, unsigned long key, void *value);
+
+/** @brief return the value bound to *key*, NULL if not found */
+extern void *itable_get(T table, unsigned long key);
+
+/** @brief remove the binding of *key*
+ * @return the removed value, NULL if not found.
+ */
+extern void *itable_remove(T table, unsigned long key);
+
+/** @brief apply a function over all bindings, *apply* may change the values
+ * (not to NULL) but not the table. */
+extern void itable_map(T table,
+                       void apply(unsigned long key, void **value, void *cl),
+                       void *cl);
+
+#undef T
+#endif /* end of include guard: ITABLE_H */
@@ -0,0 +1,204 @@
+/* implementation of *minhash*
+ */
+#include <stdint.h>
+#include <assert.h>
+
+#include "minhash.h"
+#include "mem.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define MINHASH_SSE2
+#endif
+
+#define T minhash_t
+
+/* the slots are allocated in groups of LANES, the hashes of a group are
+ * computed together */
+#define LANES 4
+
+struct T {
+    int k;
+    int n;                  /* k rounded up to LANES */
+    uint32_t *seeds;
+    uint32_t *slots;
+};
+
+/* the finalizer of MurmurHash3, a bijection on 32 bits */
+static inline uint32_t fmix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+
+T minhash_new(int k)
+{
+    T sig;
+    int i;
+
+    assert(k > 0);
+
+    sig = (T)zalloc(sizeof(*sig));
+    sig->k = k;
+    sig->n = (k + LANES - 1) / LANES * LANES;
+    sig->seeds = zalloc(sig->n * sizeof(sig->seeds[0]));
+    sig->slots = zalloc(sig->n * sizeof(sig->slots[0]));
+    /* the i-th hash function is fmix(fmix(hash) ^ seeds[i]), the same for
+     * every signature */
+    for (i = 0; i < sig->n; i++) {
+        sig->seeds[i] = fmix((i + 1) * 0x9e3779b9U);
+        sig->slots[i] = UINT32_MAX;
+    }
+    return sig;
+}
+
+void minhash_free(T *sig)
+{
+    assert(sig && *sig);
+    zfree((*sig)->slots);
+    zfree((*sig)->seeds);
+    zfree(*sig);
+    *sig = NULL;
+}
+
+int minhash_length(T sig)
+{
+    assert(sig);
+    return sig->k;
+}
+
+const uint32_t *minhash_slots(T sig)
+{
+    assert(sig);
+    return sig->slots;
+}
+
+#ifdef MINHASH_SSE2
+/* the low 32 bits of the products of the lanes of a and b, SSE2 only
+ * multiplies the even lanes */
+static inline __m128i mullo(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/* the unsigned minimum of the lanes of a and b, SSE2 only compares signed
+ * lanes so both are shifted by 2^31 */
+static inline __m128i minu(__m128i a, __m128i b)
+{
+    const __m128i bias = _mm_set1_epi32((int)0x80000000U);
+    __m128i lt = _mm_cmplt_epi32(_mm_xor_si128(a, bias),
+                                 _mm_xor_si128(b, bias));
+    return _mm_or_si128(_mm_and_si128(lt, a), _mm_andnot_si128(lt, b));
+}
+#endif
+
+void minhash_add(T sig, unsigned hash)
+{
+    uint32_t x = fmix(hash);
+    int i;
+
+    assert(sig);
+
+#ifdef MINHASH_SSE2
+    const __m128i c1 = _mm_set1_epi32((int)0x85ebca6bU);
+    const __m128i c2 = _mm_set1_epi32((int)0xc2b2ae35U);
+    const __m128i vx = _mm_set1_epi32((int)x);
+    __m128i v, s;
+
+    for (i = 0; i < sig->n; i += LANES) {
+        v = _mm_xor_si128(vx, _mm_loadu_si128((__m128i *)(sig->seeds + i)));
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+        v = mullo(v, c1);
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 13));
+        v = mullo(v, c2);
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+        s = _mm_loadu_si128((__m128i *)(sig->slots + i));
+        _mm_storeu_si128((__m128i *)(sig->slots + i), minu(v, s));
+    }
+#else
+    for (i = 0; i < sig->n; i++) {
+        uint32_t h = fmix(x ^ sig->seeds[i]);
+        sig->slots[i] = (h < sig->slots[i]) ? h : sig->slots[i];
+    }
+#endif
+}
+
+void minhash_merge(T dst, T src)
+{
+    int i;
+
+    assert(dst && src);
+    assert(dst->k == src->k);
+
+    for (i = 0; i < dst->n; i++) {
+        if (src->slots[i] < dst->slots[i]) {
+            dst->slots[i] = src->slots[i];
+        }
+    }
+}
+
+double minhash_jaccard(T s, T t)
+{
+    int i, same = 0;
+
+    assert(s && t);
+    assert(s->k == t->k);
+
+    for (i = 0; i < s->k; i++) {
+        same += s->slots[i] == t->slots[i];
+    }
+    return (double)same / s->k;
+}
+
+/* the closure of a worker of *set_minhash* */
+struct worker {
+    T sig;
+    unsigned (*hash)(const void *x);
+};
+
+static void add_member(const void *member, void *wcl)
+{
+    struct worker *w = wcl;
+    minhash_add(w->sig, w->hash(member));
+}
+
+static void merge_worker(void *wcl, void *cl)
+{
+    struct worker *w = wcl;
+    minhash_merge(cl, w->sig);
+    minhash_free(&w->sig);
+}
+
+T set_minhash(set_t set, int k, int nworkers)
+{
+    T sig;
+    struct worker *workers;
+    void **wcl;
+    int i;
+
+    assert(set);
+    assert(nworkers > 0);
+
+    sig = minhash_new(k);
+    workers = zalloc(nworkers * sizeof(*workers));
+    wcl = zalloc(nworkers * sizeof(*wcl));
+    for (i = 0; i < nworkers; i++) {
+        workers[i].sig = minhash_new(k);
+        workers[i].hash = set_hash(set);
+        wcl[i] = &workers[i];
+    }
+    /* every worker builds the signature of its part of the set, the union
+     * of the parts is their slot-wise minimum */
+    set_map_parallel(set, nworkers, add_member, wcl, merge_worker, sig);
+
+    zfree(wcl);
+    zfree(workers);
+    return sig;
+}
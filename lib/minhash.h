@@ -0,0 +1,55 @@
+/** @file minhash.h
+ * @brief MinHash signatures, to estimate the Jaccard similarity of sets.
+ *
+ * A signature keeps, for each of its *k* hash functions, the smallest value
+ * taken over the keys added to it. Two sets agree on a slot with a
+ * probability equal to their Jaccard similarity |s & t| / |s | t|, so the
+ * fraction of equal slots estimates it with a standard error of about
+ * sqrt(J(1 - J) / k), whatever the size of the sets.
+ *
+ * Keys are added by their 32-bit hash, a signature of a *set_t* is built
+ * from the hash function of the set. The *k* hashes of a key are computed
+ * four at a time with SSE2 when available.
+ */
+#ifndef MINHASH_H
+#define MINHASH_H
+
+#include <stdint.h>
+#include "set.h"
+
+#define T minhash_t
+typedef struct T *T;
+
+/** @brief create an empty signature of *k* slots. Signatures of the same *k*
+ * use the same hash functions and can be compared or merged */
+extern T minhash_new(int k);
+
+/** @brief build the signature of the members of *set*, hashed by the hash
+ * function of the set.
+ * @param nworkers the number of threads to split the set over, see
+ * *set_map_parallel*.
+ */
+extern T set_minhash(set_t set, int k, int nworkers);
+
+/** @brief free a signature */
+extern void minhash_free(T *sig);
+
+/** @brief return the number of slots */
+extern int minhash_length(T sig);
+
+/** @brief return the slots, *minhash_length* of them */
+extern const uint32_t *minhash_slots(T sig);
+
+/** @brief add the key of hash *hash* */
+extern void minhash_add(T sig, unsigned hash);
+
+/** @brief make *dst* the signature of the union of its keys and the keys of
+ * *src* */
+extern void minhash_merge(T dst, T src);
+
+/** @brief estimate the Jaccard similarity of the sets of two signatures of
+ * the same length, 1 for two empty sets */
+extern double minhash_jaccard(T s, T t);
+
+#undef T
+#endif /* end of include guard: MINHASH_H */
@@ -0,0 +1,384 @@
+/* implementation of *mtable*
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mtable.h"
+#include "mem.h"
+#include "dbg.h"
+
+#define T mtable_t
+
+/* Layout of the file, every part starts at a multiple of 8 bytes
+ *
+ * +--------------------+
+ * | header             |
+ * +--------------------+
+ * | buckets[n+1]       | entries of bucket i are [buckets[i], buckets[i+1])
+ * +--------------------+
+ * | entries[length]    | hash and position of every key
+ * +--------------------+
+ * | values[length]     | value of entries[i], value_size bytes each
+ * +--------------------+
+ * | keys               | null-terminated keys, one after another
+ * +--------------------+
+ */
+#define MAGIC "zzmtbl1"
+
+struct header {
+    char magic[8];
+    uint32_t nbuckets;          /* a power of two */
+    uint32_t value_size;
+    uint32_t length;
+    uint32_t unused;
+    uint64_t keys_size;
+};
+
+struct entry {
+    uint32_t hash;
+    uint32_t key_len;
+    uint64_t key_off;           /* from the start of keys */
+};
+
+struct T {
+    void *base;
+    size_t size;
+    const struct header *header;
+    const uint32_t *buckets;
+    const struct entry *entries;
+    const char *values;
+    const char *keys;
+};
+
+#define align8(n) (((n) + 7) & ~(uint64_t)7)
+
+/* FNV-1a, it is part of the file format and must never change */
+static inline uint32_t hash(const char *key, int len)
+{
+    uint32_t h = 2166136261U;
+    int i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/* the offset of each part, given the header */
+static uint64_t offset_buckets(const struct header *h)
+{
+    (void)h;
+    return align8(sizeof(struct header));
+}
+
+static uint64_t offset_entries(const struct header *h)
+{
+    return align8(offset_buckets(h) + (h->nbuckets + 1) * sizeof(uint32_t));
+}
+
+static uint64_t offset_values(const struct header *h)
+{
+    return offset_entries(h) + (uint64_t)h->length * sizeof(struct entry);
+}
+
+static uint64_t offset_keys(const struct header *h)
+{
+    return align8(offset_values(h) + (uint64_t)h->length * h->value_size);
+}
+
+/* write *size* bytes at *offset*, padding with zeros from the current
+ * position */
+static int write_at(FILE *fp, uint64_t offset, const void *data, size_t size)
+{
+    long pos = ftell(fp);
+    if (pos < 0) {
+        return -1;
+    }
+    for (; (uint64_t)pos < offset; pos++) {
+        if (putc(0, fp) == EOF) {
+            return -1;
+        }
+    }
+    if (size > 0 && fwrite(data, size, 1, fp) != 1) {
+        return -1;
+    }
+    return 0;
+}
+
+/* the mode of a file created by open(2) under the process umask, which is
+ * read once since umask() can only read it by changing it */
+static mode_t file_mode(void)
+{
+    static mode_t mode = (mode_t)-1;
+    mode_t mask;
+
+    if (mode == (mode_t)-1) {
+        mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+    return mode;
+}
+
+int table_freeze_to_file(table_t table, const char *path, int value_size)
+{
+    struct header header;
+    struct entry *entries;
+    uint32_t *buckets;
+    char *values;
+    void **array;
+    int *order;
+    int i, n, fd, err;
+    FILE *fp;
+    char *tmp = NULL;
+    int ret = -1;
+
+    assert(table);
+    assert(path);
+    assert(value_size > 0);
+
+    n = table_length(table);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.value_size = value_size;
+    header.length = n;
+    for (header.nbuckets = 1; header.nbuckets < (uint32_t)n;
+            header.nbuckets <<= 1) {
+        /* pass */
+    }
+
+    array = table_to_array(table, NULL);
+    entries = zalloc((n + 1) * sizeof(*entries));
+    buckets = zcalloc(header.nbuckets + 1, sizeof(*buckets));
+    order = zalloc((n + 1) * sizeof(*order));
+    values = zalloc((size_t)n * value_size + 1);
+
+    /* count the keys of every bucket, then turn the counts into the start
+     * of each bucket */
+    for (i = 0; i < n; i++) {
+        const char *key = array[2*i];
+        int len = strlen(key);
+        uint32_t h = hash(key, len);
+        buckets[(h & (header.nbuckets - 1)) + 1] ++;
+        entries[i].hash = h;
+        entries[i].key_len = len;
+    }
+    for (i = 0; i < (int)header.nbuckets; i++) {
+        buckets[i+1] += buckets[i];
+    }
+
+    /* place binding i at order[i], keys are written in that order too */
+    {
+        uint32_t *next = zalloc(header.nbuckets * sizeof(*next));
+        memcpy(next, buckets, header.nbuckets * sizeof(*next));
+        for (i = 0; i < n; i++) {
+            order[i] = next[entries[i].hash & (header.nbuckets - 1)]++;
+        }
+        zfree(next);
+    }
+
+    struct entry *sorted = zalloc((n + 1) * sizeof(*sorted));
+    const char **keys = zalloc((n + 1) * sizeof(*keys));
+    for (i = 0; i < n; i++) {
+        sorted[order[i]] = entries[i];
+        keys[order[i]] = array[2*i];
+        memcpy(values + (size_t)order[i] * value_size, array[2*i+1],
+               value_size);
+    }
+    for (i = 0; i < n; i++) {
+        sorted[i].key_off = header.keys_size;
+        header.keys_size += sorted[i].key_len + 1;
+    }
+
+    /* write a temporary file next to *path* and rename it over *path* once
+     * complete, readers never map a half-written table */
+    tmp = zalloc(strlen(path) + 8);
+    sprintf(tmp, "%s.XXXXXX", path);
+    fd = mkstemp(tmp);
+    if (fd < 0) {
+        goto out;
+    }
+    if (fchmod(fd, file_mode()) < 0 || (fp = fdopen(fd, "wb")) == NULL) {
+        close(fd);
+        goto fail;
+    }
+    if (write_at(fp, 0, &header, sizeof(header)) < 0
+            || write_at(fp, offset_buckets(&header), buckets,
+                        (header.nbuckets + 1) * sizeof(*buckets)) < 0
+            || write_at(fp, offset_entries(&header), sorted,
+                        (size_t)n * sizeof(*sorted)) < 0
+            || write_at(fp, offset_values(&header), values,
+                        (size_t)n * value_size) < 0
+            || write_at(fp, offset_keys(&header), NULL, 0) < 0) {
+        fclose(fp);
+        goto fail;
+    }
+    for (i = 0; i < n; i++) {
+        if (fwrite(keys[i], sorted[i].key_len + 1, 1, fp) != 1) {
+            fclose(fp);
+            goto fail;
+        }
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) < 0) {
+        fclose(fp);
+        goto fail;
+    }
+    if (fclose(fp) == 0 && rename(tmp, path) == 0) {
+        ret = 0;
+        goto out;
+    }
+
+fail:
+    err = errno;
+    unlink(tmp);
+    errno = err;
+out:
+    zfree(tmp);
+    zfree(keys);
+    zfree(sorted);
+    zfree(values);
+    zfree(order);
+    zfree(buckets);
+    zfree(entries);
+    zfree(array);
+    return ret;
+}
+
+/* does the file of *size* bytes at *base* hold a table that *mtable_get*
+ * can search without leaving the mapping? */
+static int valid(const void *base, uint64_t size)
+{
+    const struct header *h = base;
+    const uint32_t *buckets;
+    const struct entry *entries;
+    uint32_t i;
+
+    if (memcmp(h->magic, MAGIC, sizeof(h->magic)) != 0
+            || h->nbuckets == 0 || (h->nbuckets & (h->nbuckets - 1)) != 0
+            || h->value_size == 0
+            || offset_values(h) > size) {
+        return 0;
+    }
+    /* the values, then the keys, end the file; the size of the values
+     * alone can make offset_keys overflow */
+    if ((uint64_t)h->length * h->value_size > size - offset_values(h)
+            || offset_keys(h) > size
+            || h->keys_size != size - offset_keys(h)) {
+        return 0;
+    }
+
+    /* the buckets split [0, length) into ranges in order */
+    buckets = (const uint32_t *)((const char *)base + offset_buckets(h));
+    if (buckets[0] != 0 || buckets[h->nbuckets] != h->length) {
+        return 0;
+    }
+    for (i = 0; i < h->nbuckets; i++) {
+        if (buckets[i] > buckets[i+1]) {
+            return 0;
+        }
+    }
+
+    /* every key and its null byte lie within the keys */
+    entries = (const struct entry *)((const char *)base + offset_entries(h));
+    for (i = 0; i < h->length; i++) {
+        if (entries[i].key_off >= h->keys_size
+                || entries[i].key_len >= h->keys_size - entries[i].key_off) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+T mtable_open(const char *path)
+{
+    struct stat st;
+    const struct header *h;
+    void *base;
+    int fd;
+    T table;
+
+    assert(path);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct header)) {
+        close(fd);
+        return NULL;
+    }
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    h = base;
+    if (!valid(base, st.st_size)) {
+        log_err("mtable_open: '%s' is not a valid table file\n", path);
+        munmap(base, st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    table = (T)zalloc(sizeof(*table));
+    table->base = base;
+    table->size = st.st_size;
+    table->header = h;
+    table->buckets = (const uint32_t *)((char *)base + offset_buckets(h));
+    table->entries = (const struct entry *)((char *)base + offset_entries(h));
+    table->values = (const char *)base + offset_values(h);
+    table->keys = (const char *)base + offset_keys(h);
+
+    return table;
+}
+
+void mtable_close(T *table)
+{
+    assert(table && *table);
+    munmap((*table)->base, (*table)->size);
+    zfree(*table);
+    *table = NULL;
+}
+
+int mtable_length(T table)
+{
+    assert(table);
+    return table->header->length;
+}
+
+int mtable_value_size(T table)
+{
+    assert(table);
+    return table->header->value_size;
+}
+
+const void *mtable_get(T table, const char *key)
+{
+    uint32_t h, b, i;
+    int len;
+
+    assert(table);
+    assert(key);
+
+    len = strlen(key);
+    h = hash(key, len);
+    b = h & (table->header->nbuckets - 1);
+    for (i = table->buckets[b]; i < table->buckets[b+1]; i++) {
+        const struct entry *e = &table->entries[i];
+        if (e->hash == h && e->key_len == (uint32_t)len
+                && memcmp(table->keys + e->key_off, key, len) == 0) {
+            return table->values + (size_t)i * table->header->value_size;
+        }
+    }
+
+    return NULL;
+}
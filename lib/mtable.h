@@ -0,0 +1,55 @@
+/** @file mtable.h
+ * @brief read-only tables mapped from a file.
+ *
+ * A table whose keys are strings (atoms for instance) and whose values are
+ * fixed-size plain data can be written to a file once with
+ * *table_freeze_to_file*, and then opened by any number of processes with
+ * *mtable_open*. The file is mmapped as it is, there is nothing to rebuild
+ * at load time and the processes share the same pages.
+ *
+ * The file only holds offsets, it is independent of the address it is mapped
+ * at, but it uses the byte order of the machine that wrote it.
+ */
+#ifndef MTABLE_H
+#define MTABLE_H
+
+#include "table.h"
+
+#define T mtable_t
+typedef struct T *T;
+
+/** @brief write *table* to the file *path*
+ * @param table the table to write, its keys should be null-terminated
+ * strings.
+ * @param value_size every value of *table* points to *value_size* bytes,
+ * which are copied into the file. Values of an inline table (see
+ * *table_new_inline*) already do.
+ * The file gets mode 0666 masked by the umask, as if created by fopen.
+ * @return 0 on success, -1 on failure with errno set.
+ */
+extern int table_freeze_to_file(table_t table, const char *path,
+                                int value_size);
+
+/** @brief map a file written by *table_freeze_to_file*
+ * @return the read-only table, NULL if the file cannot be mapped or is not a
+ * valid table.
+ */
+extern T mtable_open(const char *path);
+
+/** @brief unmap the table */
+extern void mtable_close(T *table);
+
+/** @brief return the number of bindings */
+extern int mtable_length(T table);
+
+/** @brief return the size of every value */
+extern int mtable_value_size(T table);
+
+/** @brief search for a key
+ * @param key a null-terminated string
+ * @return a pointer to the value inside the mapping, NULL if not found.
+ */
+extern const void *mtable_get(T table, const char *key);
+
+#undef T
+#endif /* end of include guard: MTABLE_H */
@@ -0,0 +1,274 @@
+/* implementation of *ptable*
+ */
+#include <limits.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "ptable.h"
+#include "mem.h"
+
+#define T ptable_t
+
+/* grow the buckets when the average chain is longer than this */
+#define MAX_LOAD 2
+
+/* Every binding is on two chains: the chain of its pair in *buckets*, and
+ * the chain of its first key in *prefix*. Both arrays have *size* entries.
+ * The prefix chain is doubly linked through *pprev*, all the pairs of a
+ * first key share it and a binding leaves it without walking it.
+ */
+struct T {
+    int size;               /* a power of two */
+    int length;
+    unsigned timestamp;     /* used in ptable_map to indicate that table
+                               should not change while doing *map* */
+    struct binding {
+        struct binding *link;   /* next in the same pair bucket */
+        struct binding *plink;  /* next in the same prefix bucket */
+        struct binding **pprev; /* the plink, or prefix entry, pointing to
+                                   this binding */
+        const void *k1;
+        const void *k2;
+        void *value;
+    } **buckets, **prefix;
+};
+
+static inline unsigned long mix(unsigned long x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9UL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebUL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* the pair hash combines both keys, so that (a, b) and (b, a) differ */
+#define hash1(k1) mix((unsigned long)(k1))
+#define hash2(k1, k2) mix(hash1(k1) ^ ((unsigned long)(k2) * 0x9e3779b97f4a7c15UL))
+
+T ptable_new(int hint)
+{
+    T table;
+
+    assert(hint >= 0);
+    table = (T)zalloc(sizeof(*table));
+    for (table->size = 16; table->size < hint / MAX_LOAD
+            && table->size < INT_MAX/2; table->size <<= 1) {
+        /* pass */
+    }
+    table->buckets = zcalloc(table->size, sizeof(table->buckets[0]));
+    table->prefix = zcalloc(table->size, sizeof(table->prefix[0]));
+    table->length = 0;
+    table->timestamp = 0;
+
+    return table;
+}
+
+void ptable_free(T *table,
+                 void destroy(const void *k1, const void *k2, void *value))
+{
+    int i;
+    struct binding *p, *q;
+
+    assert(table && *table);
+    for (i = 0; i < (*table)->size; i++) {
+        for (p = (*table)->buckets[i]; p; p = q) {
+            q = p->link;
+            if (destroy) {
+                destroy(p->k1, p->k2, p->value);
+            }
+            zfree(p);
+        }
+    }
+    zfree((*table)->prefix);
+    zfree((*table)->buckets);
+    zfree(*table);
+    *table = NULL;
+}
+
+int ptable_length(T table)
+{
+    assert(table);
+    return table->length;
+}
+
+/* return the link pointing to the binding of (k1, k2), or the NULL link at
+ * the end of its chain */
+static struct binding **lookup(T table, const void *k1, const void *k2)
+{
+    struct binding **pp;
+
+    pp = &table->buckets[hash2(k1, k2) & (table->size - 1)];
+    for (; *pp; pp = &(*pp)->link) {
+        if ((*pp)->k1 == k1 && (*pp)->k2 == k2) {
+            break;
+        }
+    }
+    return pp;
+}
+
+/* push *p* on the prefix chain *head* */
+static inline void prefix_push(struct binding **head, struct binding *p)
+{
+    p->plink = *head;
+    if (*head) {
+        (*head)->pprev = &p->plink;
+    }
+    p->pprev = head;
+    *head = p;
+}
+
+static void grow(T table)
+{
+    int i, size = table->size << 1;
+    struct binding **buckets, **prefix, *p, *q;
+    unsigned long h;
+
+    buckets = zcalloc(size, sizeof(buckets[0]));
+    prefix = zcalloc(size, sizeof(prefix[0]));
+    for (i = 0; i < table->size; i++) {
+        for (p = table->buckets[i]; p; p = q) {
+            q = p->link;
+            h = hash2(p->k1, p->k2) & (size - 1);
+            p->link = buckets[h];
+            buckets[h] = p;
+            h = hash1(p->k1) & (size - 1);
+            prefix_push(&prefix[h], p);
+        }
+    }
+    zfree(table->buckets);
+    zfree(table->prefix);
+    table->buckets = buckets;
+    table->prefix = prefix;
+    table->size = size;
+}
+
+void *ptable_get(T table, const void *k1, const void *k2)
+{
+    struct binding *p;
+
+    assert(table);
+    p = *lookup(table, k1, k2);
+    return p ? p->value : NULL;
+}
+
+void *ptable_put(T table, const void *k1, const void *k2, void *value)
+{
+    struct binding **pp, *p;
+    unsigned long h;
+    void *prev;
+
+    assert(table);
+
+    pp = lookup(table, k1, k2);
+    table->timestamp ++;
+    if (*pp) {
+        prev = (*pp)->value;
+        (*pp)->value = value;
+        return prev;
+    }
+
+    p = (struct binding *)zalloc(sizeof(*p));
+    p->k1 = k1;
+    p->k2 = k2;
+    p->value = value;
+    p->link = NULL;
+    *pp = p;
+    h = hash1(k1) & (table->size - 1);
+    prefix_push(&table->prefix[h], p);
+
+    if (++table->length > MAX_LOAD * table->size && table->size < INT_MAX/2) {
+        grow(table);
+    }
+    return NULL;
+}
+
+void *ptable_remove(T table, const void *k1, const void *k2)
+{
+    struct binding **pp, *p;
+    void *value;
+
+    assert(table);
+
+    pp = lookup(table, k1, k2);
+    p = *pp;
+    if (p == NULL) {
+        return NULL;
+    }
+    table->timestamp ++;
+    *pp = p->link;
+
+    *p->pprev = p->plink;
+    if (p->plink) {
+        p->plink->pprev = p->pprev;
+    }
+
+    value = p->value;
+    zfree(p);
+    table->length --;
+    return value;
+}
+
+void ptable_map(T table,
+                void apply(const void *k1, const void *k2, void **value,
+                           void *cl),
+                void *cl)
+{
+    int i;
+    unsigned timestamp;
+    struct binding *p;
+
+    assert(table);
+    assert(apply);
+    timestamp = table->timestamp;
+
+    for (i = 0; i < table->size; i++) {
+        for (p = table->buckets[i]; p; p = p->link) {
+            apply(p->k1, p->k2, &p->value, cl);
+            assert(table->timestamp == timestamp);
+        }
+    }
+    (void)timestamp;
+}
+
+void ptable_map_prefix(T table, const void *k1,
+                       void apply(const void *k1, const void *k2,
+                                  void **value, void *cl),
+                       void *cl)
+{
+    unsigned timestamp;
+    struct binding *p;
+
+    assert(table);
+    assert(apply);
+    timestamp = table->timestamp;
+
+    for (p = table->prefix[hash1(k1) & (table->size - 1)]; p; p = p->plink) {
+        if (p->k1 == k1) {
+            apply(p->k1, p->k2, &p->value, cl);
+            assert(table->timestamp == timestamp);
+        }
+    }
+    (void)timestamp;
+}
+
+void **ptable_to_array(T table, void *end)
+{
+    int i, j = 0;
+    void **array;
+    struct binding *p;
+
+    assert(table);
+    array = (void **)zalloc((3*table->length + 1) * sizeof(*array));
+    for (i = 0; i < table->size; i++) {
+        for (p = table->buckets[i]; p; p = p->link) {
+            array[j++] = (void *)p->k1;
+            array[j++] = (void *)p->k2;
+            array[j++] = p->value;
+        }
+    }
+    array[j] = end;
+
+    return array;
+}
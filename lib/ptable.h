@@ -0,0 +1,65 @@
+/** @file ptable.h
+ * @brief a table keyed by pairs of pointers.
+ *
+ * A ptable binds a value to a pair of keys (k1, k2), usually atoms. It
+ * replaces a table of tables: instead of one table of k2 for every k1, all
+ * pairs live in one structure and the bindings sharing a k1 can still be
+ * visited with *ptable_map_prefix*.
+ *
+ * Keys are compared by identity, as the default comparison of *table*.
+ */
+#ifndef PTABLE_H
+#define PTABLE_H
+
+#define T ptable_t
+typedef struct T *T;
+
+/** @brief create a new table
+ * @param hint the estimated number of pairs.
+ */
+extern T ptable_new(int hint);
+
+/** @brief free a table
+ * @param destroy called on every binding, can be NULL.
+ */
+extern void ptable_free(T *table,
+                        void destroy(const void *k1, const void *k2,
+                                     void *value));
+
+/** @brief return the number of bindings */
+extern int ptable_length(T table);
+
+/** @brief bind *value* to (k1, k2)
+ * @return the previous value, NULL if the pair was not found.
+ */
+extern void *ptable_put(T table, const void *k1, const void *k2, void *value);
+
+/** @brief return the value of (k1, k2), NULL if not found */
+extern void *ptable_get(T table, const void *k1, const void *k2);
+
+/** @brief remove the binding of (k1, k2)
+ * @return the removed value, NULL if not found.
+ */
+extern void *ptable_remove(T table, const void *k1, const void *k2);
+
+/** @brief apply a function over all bindings, *apply* may change the values
+ * but not the table. */
+extern void ptable_map(T table,
+                       void apply(const void *k1, const void *k2,
+                                  void **value, void *cl),
+                       void *cl);
+
+/** @brief apply a function over the bindings whose first key is *k1* */
+extern void ptable_map_prefix(T table, const void *k1,
+                              void apply(const void *k1, const void *k2,
+                                         void **value, void *cl),
+                              void *cl);
+
+/** @brief convert a table to an array of triples: array[3*i] is k1,
+ * array[3*i+1] is k2 and array[3*i+2] the value. *end* is added after the
+ * last triple.
+ */
+extern void **ptable_to_array(T table, void *end);
+
+#undef T
+#endif /* end of include guard: PTABLE_H */
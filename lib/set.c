@@ -5,9 +5,27 @@
 #include "set.h"
 #include <dbg.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #define T set_t
 
+/* while the members of a bucket are visited, the head of the bucket that
+ * many places further is fetched */
+#define AHEAD 4
+
+/* number of members hashed and prefetched ahead in *set_member_batch*, a
+ * batch waits for two rounds of misses, enough of them should be in flight */
+#define BATCH 64
+
+/* a set grows when it has more than MAX_LOAD members per bucket, and shrinks
+ * when it has less than one member per MIN_LOAD buckets */
+#define MAX_LOAD 2
+#define MIN_LOAD 8
+
+/* a set of at most SMALL members keeps them in a single chain, *head*, and
+ * allocates no bucket array */
+#define SMALL 8
+
 struct T {
     int length;
     unsigned timestamp;
@@ -17,9 +35,14 @@ struct T {
     struct member {
         struct member *link;
         const void *member;
-    } **buckets;
+    } **buckets;            /* &head for a small set */
+    struct member *head;
+    bloom_t bloom;          /* NULL unless attached by set_bloom */
+    unsigned long fingerprint;  /* sum of mix() of the member hashes */
 };
 
+#define is_small(set) ((set)->buckets == &(set)->head)
+
 static unsigned default_hash(const void *key)
 {
     return (unsigned long)key >> 2;
@@ -30,29 +53,113 @@ static int default_cmp(const void *a, const void *b)
     return a != b;
 }
 
-T set_new(int hint, int cmp(const void *a, const void *b),
-          unsigned hash(const void *x))
+/* spread a member hash over an unsigned long, so that the fingerprints of
+ * different sets rarely collide even when their hashes are close */
+static inline unsigned long mix(unsigned h)
+{
+    unsigned long long x = (h + 1ULL) * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 32;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+    return (unsigned long)x;
+}
+
+/* start fetching the head of bucket *i* + AHEAD of *set* */
+static inline void prefetch_ahead(T set, int i)
+{
+    if (i + AHEAD < set->size) {
+        __builtin_prefetch(set->buckets[i + AHEAD]);
+    }
+}
+
+/* the number of buckets for about *hint* members */
+static int bucket_count(int hint)
 {
-    T set;
     int i;
     static int primes[] = {509, 509, 1021, 2053, 4093, 8191, 16381, 32771,
-        65521, INT_MAX};
+        65521, 131071, 262139, 524287, 1048573, 2097143, 4194301, 8388593,
+        16777213, 33554393, 67108859, 134217689, 268435399, 536870909,
+        1073741789, INT_MAX};
 
-    assert(hint >= 0);
     for (i = 1; primes[i] < hint; i++) {
         /* pass */
     }
+    return primes[i-1];
+}
+
+/* rehash the members of *set* into *size* buckets, a size of 1 makes it
+ * small */
+static void resize(T set, int size)
+{
+    int i;
+    unsigned hash_val;
+    struct member **buckets, *p, *q, *head = NULL;
+
+    buckets = (size == 1) ? &head : zcalloc(size, sizeof(buckets[0]));
+    for (i = 0; i < set->size; i++) {
+        prefetch_ahead(set, i);
+        for (p = set->buckets[i]; p; p = q) {
+            q = p->link;
+            __builtin_prefetch(q);
+            hash_val = (*set->hash)(p->member) % size;
+            p->link = buckets[hash_val];
+            buckets[hash_val] = p;
+        }
+    }
+    if (!is_small(set)) {
+        zfree(set->buckets);
+    }
+    if (size == 1) {
+        set->head = head;
+        buckets = &set->head;
+    }
+    set->buckets = buckets;
+    set->size = size;
+    set->timestamp ++;
+}
+
+/* keep the load factor of *set* within [1/MIN_LOAD, MAX_LOAD], a resized set
+ * gets a load between 1/2 and 1. A small set starts hashing past SMALL
+ * members */
+static void fit(T set)
+{
+    if (is_small(set)) {
+        if (set->length > SMALL) {
+            resize(set, bucket_count(2 * set->length));
+        }
+    } else if (set->length > MAX_LOAD * set->size
+            || (set->length < set->size / MIN_LOAD
+                && set->size > bucket_count(0))) {
+        int size = bucket_count(2 * set->length);
+        if (size != set->size) {
+            resize(set, size);
+        }
+    }
+}
+
+T set_new(int hint, int cmp(const void *a, const void *b),
+          unsigned hash(const void *x))
+{
+    T set;
 
-    set = (T)zalloc(sizeof(*set) + primes[i-1]*sizeof(set->buckets[0]));
-    set->size = primes[i-1];
+    assert(hint >= 0);
+
+    set = (T)zalloc(sizeof(*set));
     set->cmp = cmp ? cmp : default_cmp;
     set->hash = hash ? hash : default_hash;
-    set->buckets = (struct member **)(set + 1);
-    for (i = 0; i < set->size; i++) {
-        set->buckets[i] = NULL;
+    set->head = NULL;
+    set->bloom = NULL;
+    if (hint <= SMALL) {
+        set->size = 1;
+        set->buckets = &set->head;
+    } else {
+        set->size = bucket_count(hint);
+        /* the buckets are allocated apart, so that they can be resized */
+        set->buckets = zcalloc(set->size, sizeof(set->buckets[0]));
     }
     set->length = 0;
     set->timestamp = 0;
+    set->fingerprint = 0;
 
     return set;
 }
@@ -65,29 +172,96 @@ bool set_member(T set, const void *member)
     assert(member);
 
     /* search for member */
-    unsigned hash_val = 0;
-    hash_val = (*set->hash)(member) % set->size;
+    unsigned hash = (*set->hash)(member);
+    if (set->bloom && !bloom_test(set->bloom, hash)) {
+        return false;
+    }
 
-    for (p = set->buckets[hash_val]; p; p = p->link) {
+    for (p = set->buckets[hash % set->size]; p; p = p->link) {
+        /* the next node is needed unless this one matches */
+        __builtin_prefetch(p->link);
         if ((*set->cmp)(member, p->member) == 0) {
             break;
         }
     }
 
+    if (p == NULL && set->bloom) {
+        bloom_false_positive(set->bloom);
+    }
     return p != NULL;
 }
 
+/* hash members[0..n) of a batch into *hash_vals*, -1 for those the bloom
+ * filter rejects, and fetch their buckets and the first node of each */
+static void prefetch_buckets(T set, const void *members[], int n,
+                             int hash_vals[])
+{
+    int i;
+    unsigned hash;
+
+    for (i = 0; i < n; i++) {
+        assert(members[i]);
+        hash = (*set->hash)(members[i]);
+        if (set->bloom && !bloom_test(set->bloom, hash)) {
+            hash_vals[i] = -1;
+            continue;
+        }
+        hash_vals[i] = hash % set->size;
+        __builtin_prefetch(&set->buckets[hash_vals[i]]);
+    }
+    for (i = 0; i < n; i++) {
+        if (hash_vals[i] >= 0 && set->buckets[hash_vals[i]]) {
+            __builtin_prefetch(set->buckets[hash_vals[i]]);
+        }
+    }
+}
+
+void set_member_batch(T set, const void *members[], int n, bit_t out)
+{
+    int hash_vals[BATCH];
+    int i, j, m;
+    struct member *p;
+
+    assert(set);
+    assert(n >= 0);
+    assert(members && out);
+    assert(n == 0 || bit_length(out) >= n);
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < BATCH) ? n - i : BATCH;
+        prefetch_buckets(set, members + i, m, hash_vals);
+
+        for (j = 0; j < m; j++) {
+            p = NULL;
+            if (hash_vals[j] >= 0) {
+                for (p = set->buckets[hash_vals[j]]; p; p = p->link) {
+                    __builtin_prefetch(p->link);
+                    if ((*set->cmp)(members[i+j], p->member) == 0) {
+                        break;
+                    }
+                }
+                if (p == NULL && set->bloom) {
+                    bloom_false_positive(set->bloom);
+                }
+            }
+            bit_put(out, i + j, p != NULL);
+        }
+    }
+}
+
 void set_put(T set, const void *member)
 {
-    unsigned hash_val = 0;
+    unsigned hash, hash_val = 0;
     struct member *p = NULL;
 
     assert(set);
     assert(member);
 
     /* search for member */
-    hash_val = (*set->hash)(member) % set->size;
+    hash = (*set->hash)(member);
+    hash_val = hash % set->size;
     for (p = set->buckets[hash_val]; p; p = p->link) {
+        __builtin_prefetch(p->link);
         if ((*set->cmp)(member, p->member) == 0) {
             break;
         }
@@ -100,6 +274,11 @@ void set_put(T set, const void *member)
         p->link = set->buckets[hash_val];
         set->buckets[hash_val] = p;
         set->length ++;
+        set->fingerprint += mix(hash);
+        if (set->bloom) {
+            bloom_add(set->bloom, hash);
+        }
+        fit(set);
     } else {
         p->member = member;
     }
@@ -108,14 +287,15 @@ void set_put(T set, const void *member)
 
 void *set_remove(T set, const void *member)
 {
-    unsigned hash_val = 0;
+    unsigned hash, hash_val = 0;
     struct member **pp;
 
     assert(set);
     assert(member);
 
     set->timestamp ++;
-    hash_val = (*set->hash)(member) % set->size;
+    hash = (*set->hash)(member);
+    hash_val = hash % set->size;
 
     for (pp = &set->buckets[hash_val]; *pp; pp = &(*pp)->link) {
         if ((*set->cmp)(member, (*pp)->member) == 0) {
@@ -124,6 +304,8 @@ void *set_remove(T set, const void *member)
             member = p->member;
             zfree(p);
             set->length --;
+            set->fingerprint -= mix(hash);
+            fit(set);
             return (void *)member;
         }
     }
@@ -137,6 +319,12 @@ int set_length(T set)
     return set->length;
 }
 
+unsigned (*set_hash(T set))(const void *x)
+{
+    assert(set);
+    return set->hash;
+}
+
 void set_free(T *set, void destroy(void *))
 {
     assert(set && *set);
@@ -154,6 +342,12 @@ void set_free(T *set, void destroy(void *))
         }
     }
 
+    if ((*set)->bloom) {
+        bloom_free(&(*set)->bloom);
+    }
+    if (!is_small(*set)) {
+        zfree((*set)->buckets);
+    }
     zfree(*set);
     *set = NULL;
 }
@@ -175,6 +369,77 @@ void set_map(T set, void apply(const void *member, void *cl), void *cl)
     }
 }
 
+/* the share of a worker in set_map_parallel */
+struct worker {
+    T set;
+    int lo, hi;             /* buckets [lo, hi) */
+    void (*apply)(const void *member, void *wcl);
+    void *wcl;
+};
+
+static void *map_range(void *arg)
+{
+    struct worker *w = arg;
+    unsigned timestamp = w->set->timestamp;
+    struct member *p;
+    int i;
+
+    for (i = w->lo; i < w->hi; i++) {
+        for (p = w->set->buckets[i]; p; p = p->link) {
+            w->apply(p->member, w->wcl);
+            assert(w->set->timestamp == timestamp);
+        }
+    }
+    (void)timestamp;
+    return NULL;
+}
+
+void set_map_parallel(T set, int nworkers,
+                      void apply(const void *member, void *wcl),
+                      void *wcl[],
+                      void reduce(void *wcl, void *cl), void *cl)
+{
+    struct worker *workers;
+    pthread_t *tids;
+    int i;
+
+    assert(set);
+    assert(apply);
+    assert(nworkers > 0);
+
+    workers = zalloc(nworkers * sizeof(*workers));
+    tids = zalloc(nworkers * sizeof(*tids));
+    for (i = 0; i < nworkers; i++) {
+        workers[i].set = set;
+        workers[i].lo = (long)set->size * i / nworkers;
+        workers[i].hi = (long)set->size * (i + 1) / nworkers;
+        workers[i].apply = apply;
+        workers[i].wcl = wcl ? wcl[i] : NULL;
+    }
+
+    /* the calling thread takes the last range itself */
+    for (i = 0; i < nworkers - 1; i++) {
+        if (pthread_create(&tids[i], NULL, map_range, &workers[i]) != 0) {
+            map_range(&workers[i]);
+            tids[i] = pthread_self();
+        }
+    }
+    map_range(&workers[nworkers - 1]);
+    for (i = 0; i < nworkers - 1; i++) {
+        if (!pthread_equal(tids[i], pthread_self())) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+
+    if (reduce) {
+        for (i = 0; i < nworkers; i++) {
+            reduce(workers[i].wcl, cl);
+        }
+    }
+    zfree(tids);
+    zfree(workers);
+}
+
 void **set_to_array(T set, void *end)
 {
     int i,j = 0;
@@ -193,14 +458,48 @@ void **set_to_array(T set, void *end)
     return array;
 }
 
-inline int max(int a, int b)
+long set_memory_usage(T set)
+{
+    assert(set);
+    return sizeof(*set)
+        + (is_small(set) ? 0 : (long)set->size * sizeof(set->buckets[0]))
+        + (long)set->length * sizeof(struct member)
+        + (set->bloom ? bloom_memory_usage(set->bloom) : 0);
+}
+
+bloom_t set_bloom(T set, int expected)
 {
-    return (a > b) ? a : b;
+    struct member *p;
+    int i;
+
+    assert(set);
+    assert(expected >= 0);
+
+    if (set->bloom) {
+        bloom_free(&set->bloom);
+    }
+    if (expected == 0) {
+        return NULL;
+    }
+
+    set->bloom = bloom_new(expected > set->length ? expected : set->length);
+    for (i = 0; i < set->size; i++) {
+        for (p = set->buckets[i]; p; p = p->link) {
+            bloom_add(set->bloom, (*set->hash)(p->member));
+        }
+    }
+    return set->bloom;
 }
 
-inline int min(int a, int b)
+void set_shrink_to_fit(T set)
 {
-    return (a < b) ? a : b;
+    int size;
+
+    assert(set);
+    size = (set->length <= SMALL) ? 1 : bucket_count(set->length);
+    if (size < set->size) {
+        resize(set, size);
+    }
 }
 
 /** @brief clone a set
@@ -219,7 +518,9 @@ static T copy(T t, int hint)
     unsigned hash_val = 0;
 
     for (i = 0; i < t->size; i++) {
+        prefetch_ahead(t, i);
         for (q = t->buckets[i]; q; q = q->link) {
+            __builtin_prefetch(q->link);
             p = (struct member *)zalloc(sizeof(*p));
             p->member = q->member;
             hash_val = set->hash(p->member) % set->size;
@@ -229,6 +530,7 @@ static T copy(T t, int hint)
             set->length ++;
         }
     }
+    set->fingerprint = t->fingerprint;
 
     return set;
 }
@@ -237,20 +539,22 @@ T set_union(T s, T t)
 {
     if (s == NULL) {
         assert(t);
-        return copy(t, t->size);
+        return copy(t, t->length);
     } else if (t == NULL) {
         assert(s);
-        return copy(s, s->size);
+        return copy(s, s->length);
     } else if (s->length < t->length) {
         return set_union(t, s);
     } else {
-        T set = copy(s, max(s->size, t->size));
+        T set = copy(s, s->length + t->length);
         assert(s->cmp == t->cmp && s->hash == t->hash);
 
         int i;
         struct member *q;
         for (i = 0; i < t->size; i++) {
+            prefetch_ahead(t, i);
             for (q = t->buckets[i]; q; q = q->link) {
+                __builtin_prefetch(q->link);
                 set_put(set, q->member);
             }
         }
@@ -263,34 +567,41 @@ T set_inter(T s, T t)
 {
     if (s == NULL) {
         assert(t);
-        return set_new(t->size, t->cmp, t->hash);
+        return set_new(0, t->cmp, t->hash);
     } else if (t == NULL) {
         assert(s);
-        return set_new(s->size, s->cmp, s->hash);
+        return set_new(0, s->cmp, s->hash);
     } else if (s->length < t->length) {
         return set_inter(t, s);
     } else {
-        T set = set_new(min(s->size, t->size), s->cmp, s->hash);
+        /* t is the smaller set */
+        T set = set_new(t->length, s->cmp, s->hash);
         assert(s->cmp == t->cmp && s->hash == t->hash);
 
         /* for each member q in t, if q is in s, add it the new set */
         int i;
         struct member *q;
         struct member *p;
-        unsigned hash_val;
+        unsigned hash, hash_val;
         for (i = 0; i < t->size; i++) {
+            prefetch_ahead(t, i);
             for (q = t->buckets[i]; q; q = q->link) {
+                __builtin_prefetch(q->link);
                 if (set_member(s, q->member)) {
                     p = (struct member *)zalloc(sizeof(*p));
                     p->member = q->member;
-                    hash_val = set->hash(p->member) % set->size;
+                    hash = set->hash(p->member);
+                    hash_val = hash % set->size;
 
                     p->link = set->buckets[hash_val];
                     set->buckets[hash_val] = p;
                     set->length ++;
+                    set->fingerprint += mix(hash);
                 }
             }
         }
+        /* the result can be much smaller than its estimate */
+        fit(set);
         return set;
     }
 }
@@ -299,32 +610,38 @@ T set_minus(T s, T t)
 {
     if (s == NULL) {
         assert(t);
-        return set_new(t->size, t->cmp, t->hash);
+        return set_new(0, t->cmp, t->hash);
     } else if (t == NULL) {
         assert(s);
-        return copy(s, s->size);
+        return copy(s, s->length);
     } else {
-        T set = set_new(s->size, s->cmp, s->hash);
+        T set = set_new(s->length, s->cmp, s->hash);
         assert(s->cmp == t->cmp && s->hash == t->hash);
 
         /* for each member q in s, if it is not in t, add it to new set */
         int i;
         struct member *q;
         struct member *p;
-        unsigned hash_val;
+        unsigned hash, hash_val;
         for (i = 0; i < s->size; i++) {
+            prefetch_ahead(s, i);
             for (q = s->buckets[i]; q; q = q->link) {
+                __builtin_prefetch(q->link);
                 if (!set_member(t, q->member)) {
                     p = (struct member *)zalloc(sizeof(*p));
                     p->member = q->member;
-                    hash_val = set->hash(p->member) % set->size;
+                    hash = set->hash(p->member);
+                    hash_val = hash % set->size;
 
                     p->link = set->buckets[hash_val];
                     set->buckets[hash_val] = p;
                     set->length ++;
+                    set->fingerprint += mix(hash);
                 }
             }
         }
+        /* the result can be much smaller than its estimate */
+        fit(set);
         return set;
     }
 
@@ -334,28 +651,32 @@ T set_diff(T s, T t)
 {
     if (s == NULL) {
         assert(t);
-        return copy(t, t->size);
+        return copy(t, t->length);
     } else if (t == NULL) {
-        return copy(s, s->size);
+        return copy(s, s->length);
     } else {
-        T set = set_new(min(s->size, t->size), s->cmp, t->hash);
+        T set = set_new(s->length + t->length, s->cmp, t->hash);
         assert(s->cmp == t->cmp && s->hash == t->hash);
 
         int i;
         struct member *p;
         struct member *q;
-        unsigned hash_val = 0;
+        unsigned hash, hash_val = 0;
 
         /* for each member p in s, if p isn't in t, add it to new set */
         for (i = 0; i < s->size; i++) {
+            prefetch_ahead(s, i);
             for (p = s->buckets[i]; p; p = p->link) {
+                __builtin_prefetch(p->link);
                 if (! set_member(t, p->member)) {
                     q = (struct member *)zalloc(sizeof(*q));
                     q->member = p->member;
-                    hash_val = set->hash(q->member) % set->size;
+                    hash = set->hash(q->member);
+                    hash_val = hash % set->size;
                     q->link = set->buckets[hash_val];
                     set->buckets[hash_val] = q;
                     set->length ++;
+                    set->fingerprint += mix(hash);
                 }
             }
         }
@@ -366,18 +687,184 @@ T set_diff(T s, T t)
         s = u;
         /* copy exactly from the paragraph above */
         for (i = 0; i < s->size; i++) {
+            prefetch_ahead(s, i);
             for (p = s->buckets[i]; p; p = p->link) {
+                __builtin_prefetch(p->link);
                 if (! set_member(t, p->member)) {
                     q = (struct member *)zalloc(sizeof(*q));
                     q->member = p->member;
-                    hash_val = set->hash(q->member) % set->size;
+                    hash = set->hash(q->member);
+                    hash_val = hash % set->size;
                     q->link = set->buckets[hash_val];
                     set->buckets[hash_val] = q;
                     set->length ++;
+                    set->fingerprint += mix(hash);
                 }
             }
         }
 
+        fit(set);
         return set;
     }
 }
+
+void set_union_into(T dst, T src)
+{
+    int i;
+    struct member *q;
+
+    assert(dst && src);
+    assert(dst != src);
+    assert(dst->cmp == src->cmp && dst->hash == src->hash);
+
+    /* only the members of src missing in dst get a new node */
+    for (i = 0; i < src->size; i++) {
+        prefetch_ahead(src, i);
+        for (q = src->buckets[i]; q; q = q->link) {
+            __builtin_prefetch(q->link);
+            set_put(dst, q->member);
+        }
+    }
+}
+
+/* unlink and free the nodes of *dst* whose membership in *src* is *in* */
+static void filter(T dst, T src, bool in)
+{
+    int i;
+    struct member **pp, *p;
+
+    for (i = 0; i < dst->size; i++) {
+        prefetch_ahead(dst, i);
+        for (pp = &dst->buckets[i]; *pp; ) {
+            p = *pp;
+            __builtin_prefetch(p->link);
+            if (set_member(src, p->member) == in) {
+                *pp = p->link;
+                dst->fingerprint -= mix((*dst->hash)(p->member));
+                zfree(p);
+                dst->length --;
+            } else {
+                pp = &p->link;
+            }
+        }
+    }
+    fit(dst);
+    dst->timestamp ++;
+}
+
+void set_inter_into(T dst, T src)
+{
+    assert(dst && src);
+    assert(dst != src);
+    assert(dst->cmp == src->cmp && dst->hash == src->hash);
+
+    filter(dst, src, false);
+}
+
+void set_minus_into(T dst, T src)
+{
+    int i;
+    struct member *q;
+
+    assert(dst && src);
+    assert(dst != src);
+    assert(dst->cmp == src->cmp && dst->hash == src->hash);
+
+    if (dst->length <= src->length) {
+        filter(dst, src, true);
+        return;
+    }
+
+    /* src is the smaller one, remove its members from dst */
+    for (i = 0; i < src->size; i++) {
+        prefetch_ahead(src, i);
+        for (q = src->buckets[i]; q; q = q->link) {
+            __builtin_prefetch(q->link);
+            set_remove(dst, q->member);
+        }
+    }
+}
+
+void set_diff_into(T dst, T src)
+{
+    int i;
+    struct member *q;
+
+    assert(dst && src);
+    assert(dst != src);
+    assert(dst->cmp == src->cmp && dst->hash == src->hash);
+
+    /* a member of src leaves dst if it is there, and joins it otherwise */
+    for (i = 0; i < src->size; i++) {
+        prefetch_ahead(src, i);
+        for (q = src->buckets[i]; q; q = q->link) {
+            __builtin_prefetch(q->link);
+            if (set_remove(dst, q->member) == NULL) {
+                set_put(dst, q->member);
+            }
+        }
+    }
+}
+
+/* whether the membership in *t* of every member of *s* is *in*, stopping at
+ * the first member that is not */
+static bool every(T s, T t, bool in)
+{
+    int i;
+    struct member *q;
+
+    for (i = 0; i < s->size; i++) {
+        prefetch_ahead(s, i);
+        for (q = s->buckets[i]; q; q = q->link) {
+            __builtin_prefetch(q->link);
+            if (set_member(t, q->member) != in) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool set_eq(T s, T t)
+{
+    assert(s && t);
+    assert(s->cmp == t->cmp && s->hash == t->hash);
+
+    if (s == t) {
+        return true;
+    }
+    if (s->length != t->length || s->fingerprint != t->fingerprint) {
+        return false;
+    }
+    /* equal fingerprints are very likely equal sets, but not surely */
+    return every(s, t, true);
+}
+
+bool set_subset(T s, T t)
+{
+    assert(s && t);
+    assert(s->cmp == t->cmp && s->hash == t->hash);
+
+    if (s == t) {
+        return true;
+    }
+    if (s->length > t->length) {
+        return false;
+    }
+    return every(s, t, true);
+}
+
+bool set_disjoint(T s, T t)
+{
+    assert(s && t);
+    assert(s->cmp == t->cmp && s->hash == t->hash);
+
+    if (s->length == 0 || t->length == 0) {
+        return true;
+    }
+    if (s == t) {
+        return false;
+    }
+    /* test the members of the smaller set against the larger one */
+    return (s->length <= t->length) ? every(s, t, false) : every(t, s, false);
+}
@@ -3,14 +3,17 @@
 #define SET_H
 
 #include <stdbool.h>
+#include "bloom.h"
+#include "bit.h"
 
 #define T set_t
 typedef struct T *T;
 
 /* exported functions */
 
-/** @brief create a new set
- * @param hint the size of the set
+/** @brief create a new set, it grows and shrinks with its number of members.
+ * A set of a few members allocates no buckets until it grows.
+ * @param hint the estimated number of members
  * @param cmp the function used to compare two set elements.
  * @param hash hash function used to generate values for set elemtns.
  * @return a new set.
@@ -33,6 +36,11 @@ extern void set_free(T *set, void destroy(void *));
  */
 extern int set_length(T set);
 
+/** @brief return the hash function of the set, the default one if NULL was
+ * given to *set_new*
+ */
+extern unsigned (*set_hash(T set))(const void *x);
+
 /** @brief test if an item is a member of a set
  * @param set the set to be tested
  * @param member the member to be tested
@@ -40,6 +48,15 @@ extern int set_length(T set);
  */
 extern bool set_member(T set, const void *member);
 
+/** @brief test *n* members at once.
+ * All members are hashed and their buckets prefetched, a batch at a time,
+ * before any chain is searched, so the cache misses of different members
+ * overlap.
+ * @param out receives 1 in bit i if members[i] is in *set*, 0 otherwise. It
+ * should have at least *n* bits.
+ */
+extern void set_member_batch(T set, const void *members[], int n, bit_t out);
+
 /** @brief add a new item to the set
  * @param set the set to be added into
  * @param member the item to be added.
@@ -65,6 +82,18 @@ extern void set_map(T set,
                     void apply(const void *member, void *cl),
                     void *cl);
 
+/** @brief set_map_parallel is like set_map, but the buckets are split over
+ * *nworkers* threads. Worker i passes wcl[i] to *apply*.
+ * @param wcl the per-worker closures, *nworkers* of them, can be NULL.
+ * @param reduce called as reduce(wcl[i], cl) for every worker in order, on
+ * the calling thread after all workers finish. Can be NULL.
+ * @return void
+ */
+extern void set_map_parallel(T set, int nworkers,
+                             void apply(const void *member, void *wcl),
+                             void *wcl[],
+                             void reduce(void *wcl, void *cl), void *cl);
+
 /** @brief convert a set into an array
  * @param set the set to be convertted
  * @param end the element to be added to the end of the generated array
@@ -72,6 +101,30 @@ extern void set_map(T set,
  */
 extern void **set_to_array(T set, void *end);
 
+/** @brief return the number of bytes used by the set, its buckets and its
+ * member nodes. The members themselves are not counted.
+ */
+extern long set_memory_usage(T set);
+
+/** @brief put a Bloom filter in front of *set_member* and *set_member_batch*,
+ * so that most tests of absent members return without walking a chain. The
+ * filter is fed by every later put; removed members stay in it, call
+ * *set_bloom* again to rebuild it from the current members. As for
+ * *table_bloom*, it only helps when most tests miss.
+ * @param expected the number of members to size the filter for, at least
+ * the current length is used. 0 removes the filter.
+ * @return the filter, owned by the set, whose counters can be turned on
+ * with *bloom_count* and read with *bloom_stats*. NULL if *expected* is 0.
+ */
+extern bloom_t set_bloom(T set, int expected);
+
+/** @brief reduce the number of buckets to what *set_new* would choose for
+ * the current length, returning the rest to the allocator. A set already
+ * shrinks by itself when most of its buckets are empty, this only tightens
+ * it further, down to no buckets at all for a few members.
+ */
+extern void set_shrink_to_fit(T set);
+
 /***********************************************************************
  * set operations
  ***********************************************************************/
@@ -80,5 +133,28 @@ extern T set_inter(T s, T t);
 extern T set_minus(T s, T t);
 extern T set_diff(T s, T t);
 
+/** @brief in-place versions of the set operations, *dst* becomes the result
+ * of dst op src and *src* is unchanged. The nodes of *dst* are reused, only
+ * members of *src* added to *dst* are allocated. *dst* and *src* should be
+ * different sets with the same *cmp* and *hash*.
+ */
+extern void set_union_into(T dst, T src);
+extern void set_inter_into(T dst, T src);
+extern void set_minus_into(T dst, T src);
+extern void set_diff_into(T dst, T src);
+
+/** @brief compare two sets with the same *cmp* and *hash*, without building
+ * any result. Each stops at the first member that decides the answer, and
+ * *set_eq* and *set_subset* first compare the lengths. A set also keeps
+ * an order-independent fingerprint of its member hashes, so most unequal
+ * sets of the same length are told apart by *set_eq* without looking at a
+ * member.
+ * @return true if *s* and *t* have the same members, if every member of *s*
+ * is in *t*, or if no member of *s* is in *t*.
+ */
+extern bool set_eq(T s, T t);
+extern bool set_subset(T s, T t);
+extern bool set_disjoint(T s, T t);
+
 #undef T
 #endif /* end of include guard: SET_H */
@@ -3,6 +3,8 @@
 #include <limits.h>
 #include <stddef.h>
 #include <assert.h>
+#include <string.h>
+#include <pthread.h>
 #include "table.h"
 #include "mem.h"
 
@@ -10,20 +12,42 @@
 
 #define T table_t
 
+/* number of keys hashed and prefetched ahead in the batch functions */
+#define BATCH 16
+
+/* while the bindings of a bucket are visited, the head of the bucket that
+ * many places further is fetched */
+#define AHEAD 4
+
+/* a table of at most SMALL bindings keeps them in a single chain, *head*,
+ * and allocates no bucket array */
+#define SMALL 8
+
 struct T {
     struct binding {
         struct binding *link;
         const void *key;
         void *value;
-    } **buckets;
+    } **buckets;            /* &head for a small table */
+    struct binding *head;
     int size;
     int length;
+    int value_size;         /* > 0 if values are stored after the binding */
+    struct binding *spare;  /* removed bindings kept for reuse */
+    int nspare;
+    int max_spare;
+    bloom_t bloom;          /* NULL unless attached by table_bloom */
     unsigned timestamp;     /* used in table_map to indicate that table should
                                not change while doing *map* */
     int (*cmp)(const void *a, const void *b);
     unsigned (*hash)(const void *key);
 };
 
+#define is_small(table) ((table)->buckets == &(table)->head)
+
+static void resize(T table, int size);
+static int bucket_count(int hint);
+
 static unsigned default_hash(const void *key)
 {
     return (unsigned long)key >> 2;
@@ -34,31 +58,152 @@ static int default_cmp(const void *a, const void *b)
     return a != b;
 }
 
+/* start fetching the head of bucket *i* + AHEAD of *table* */
+static inline void prefetch_ahead(T table, int i)
+{
+    if (i + AHEAD < table->size) {
+        __builtin_prefetch(table->buckets[i + AHEAD]);
+    }
+}
+
+/* add a new binding of *key* at the head of bucket *hash_val*, the value of
+ * an inline table is zeroed */
+static struct binding *bind(T table, const void *key, int hash_val)
+{
+    struct binding *p;
+
+    /* the value lives right after the binding, one allocation for both */
+    if (table->spare) {
+        p = table->spare;
+        table->spare = p->link;
+        table->nspare --;
+    } else {
+        p = (struct binding *)zalloc(sizeof(*p) + table->value_size);
+    }
+    p->key = key;
+    if (table->value_size) {
+        p->value = p + 1;
+        memset(p->value, 0, table->value_size);
+    } else {
+        p->value = NULL;
+    }
+    p->link = table->buckets[hash_val];
+    table->buckets[hash_val] = p;
+    table->length ++;
+
+    if (table->bloom) {
+        bloom_add(table->bloom, (*table->hash)(key));
+    }
+    if (is_small(table) && table->length > SMALL) {
+        resize(table, bucket_count(table->length));
+    }
+    return p;
+}
+
+/* release a binding that is no longer linked, keeping it for the next *bind*
+ * if there is room */
+static void unbind(T table, struct binding *p)
+{
+    if (table->nspare < table->max_spare) {
+        p->link = table->spare;
+        table->spare = p;
+        table->nspare ++;
+    } else {
+        zfree(p);
+    }
+}
+
+/* free the spare bindings beyond *cap* */
+static void trim_spare(T table, int cap)
+{
+    struct binding *p;
+
+    while (table->nspare > cap) {
+        p = table->spare;
+        table->spare = p->link;
+        table->nspare --;
+        zfree(p);
+    }
+}
+
 T table_new(int hint, 
             int cmp(const void *a, const void *b), 
             unsigned hash(const void *key))
 {
-    T table;
+    return table_new_inline(hint, cmp, hash, 0);
+}
+
+/* the number of buckets for about *hint* bindings */
+static int bucket_count(int hint)
+{
     int i;
     static int primes[] = {509, 509, 1021, 2053, 4093, 8191, 16381, 32771,
-        65521, INT_MAX};
-
-    assert(hint >= 0);
+        65521, 131071, 262139, 524287, 1048573, 2097143, 4194301, 8388593,
+        16777213, 33554393, 67108859, 134217689, 268435399, 536870909,
+        1073741789, INT_MAX};
 
     for (i=1; primes[i] < hint; i++) {
         /* pass */
     }
-    table = (T) zalloc(sizeof(*table) + primes[i-1]*sizeof(table->buckets[0]));
-    table->size = primes[i-1];
-    table->cmp = cmp ? cmp: default_cmp;
-    table->hash = hash ? hash: default_hash;
-    table->buckets = (struct binding **) (table+1);
+    return primes[i-1];
+}
+
+/* rehash the bindings of *table* into *size* buckets, a size of 1 makes it
+ * small */
+static void resize(T table, int size)
+{
+    int i, hash_val;
+    struct binding **buckets, *p, *q, *head = NULL;
 
-    /* initialize */
+    buckets = (size == 1) ? &head : zcalloc(size, sizeof(buckets[0]));
     for (i = 0; i < table->size; i++) {
-        table->buckets[i] = NULL;
+        for (p = table->buckets[i]; p; p = q) {
+            q = p->link;
+            hash_val = (*table->hash)(p->key) % size;
+            p->link = buckets[hash_val];
+            buckets[hash_val] = p;
+        }
+    }
+    if (!is_small(table)) {
+        zfree(table->buckets);
+    }
+    if (size == 1) {
+        table->head = head;
+        buckets = &table->head;
+    }
+    table->buckets = buckets;
+    table->size = size;
+    table->timestamp ++;
+}
+
+T table_new_inline(int hint,
+                   int cmp(const void *a, const void *b),
+                   unsigned hash(const void *key),
+                   int value_size)
+{
+    T table;
+
+    assert(hint >= 0);
+    assert(value_size >= 0);
+
+    table = (T) zalloc(sizeof(*table));
+    table->cmp = cmp ? cmp: default_cmp;
+    table->hash = hash ? hash: default_hash;
+    table->head = NULL;
+    if (hint <= SMALL) {
+        table->size = 1;
+        table->buckets = &table->head;
+    } else {
+        table->size = bucket_count(hint);
+        /* the buckets are allocated apart, so that they can be resized */
+        table->buckets = zcalloc(table->size, sizeof(table->buckets[0]));
     }
     table->length = 0;
+    table->value_size = value_size;
+    table->spare = NULL;
+    table->nspare = 0;
+    table->max_spare = 0;
+    table->bloom = NULL;
     table->timestamp = 0;
 
     return table;
@@ -66,19 +211,28 @@ T table_new(int hint,
 
 void *table_get(T table, const void *key)
 {
-    int hash_val;
+    unsigned hash;
     struct binding *p;
     assert(table);
     assert(key);
 
+    hash = (*table->hash)(key);
+    if (table->bloom && !bloom_test(table->bloom, hash)) {
+        return NULL;
+    }
+
     /* search the table for the given key */
-    hash_val = (*table->hash)(key) % table->size;
-    for (p = table->buckets[hash_val]; p; p = p->link) {
+    for (p = table->buckets[hash % table->size]; p; p = p->link) {
+        /* the next node is needed unless this one matches */
+        __builtin_prefetch(p->link);
         if ((*table->cmp)(key, p->key) == 0) {
             break;
         }
     }
 
+    if (p == NULL && table->bloom) {
+        bloom_false_positive(table->bloom);
+    }
     return p ? p->value: NULL;
 }
 
@@ -90,6 +244,7 @@ void *table_put(T table, const void *key, void *value)
 
     assert(table);
     assert(key);
+    assert(table->value_size == 0);
 
     /* search table for key */
     hash_val = (*table->hash)(key) % table->size;
@@ -100,11 +255,7 @@ void *table_put(T table, const void *key, void *value)
     }
 
     if (p == NULL) {
-        p = (struct binding *)zalloc(sizeof(*p));
-        p->key = key;
-        p->link = table->buckets[hash_val];
-        table->buckets[hash_val] = p;
-        table->length ++;
+        p = bind(table, key, hash_val);
         prev = NULL;
     } else {
         prev = p->value;
@@ -116,12 +267,256 @@ void *table_put(T table, const void *key, void *value)
     return prev;
 }
 
+void *table_slot(T table, const void *key)
+{
+    int hash_val;
+    struct binding *p;
+
+    assert(table);
+    assert(key);
+    assert(table->value_size > 0);
+
+    hash_val = (*table->hash)(key) % table->size;
+    for (p = table->buckets[hash_val]; p; p = p->link) {
+        if ((*table->cmp)(key, p->key) == 0) {
+            return p->value;
+        }
+    }
+
+    p = bind(table, key, hash_val);
+    table->timestamp ++;
+
+    return p->value;
+}
+
+unsigned table_hash_string(const void *key)
+{
+    const unsigned char *p = key;
+    unsigned hash_val = 5381;
+
+    for (; *p; p++) {
+        hash_val = hash_val * 33 + *p;
+    }
+    return hash_val;
+}
+
+int table_cmp_string(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+/* the binding of the key equal to bytes[0..len-1], computed as
+ * table_hash_string would, the bucket index is stored in *hash_val* */
+static struct binding *find_bytes(T table, const char *bytes, int len,
+                                  int *hash_val)
+{
+    unsigned h = 5381;
+    struct binding *p;
+    int i;
+
+    assert(table->hash == table_hash_string);
+    assert(bytes);
+    assert(len >= 0);
+
+    for (i = 0; i < len; i++) {
+        h = h * 33 + (unsigned char)bytes[i];
+    }
+    *hash_val = h % table->size;
+    /* a rejected key is absent, the put functions bind it right away */
+    if (table->bloom && !bloom_test(table->bloom, h)) {
+        return NULL;
+    }
+
+    for (p = table->buckets[*hash_val]; p; p = p->link) {
+        const char *key = p->key;
+        /* a shorter key stops at its '\0', which is not in *bytes* */
+        for (i = 0; i < len && key[i] == bytes[i]; i++) {
+            /* pass */
+        }
+        if (i == len && key[len] == '\0') {
+            break;
+        }
+    }
+    if (p == NULL && table->bloom) {
+        bloom_false_positive(table->bloom);
+    }
+    return p;
+}
+
+void *table_get_bytes(T table, const char *bytes, int len)
+{
+    int hash_val;
+    struct binding *p;
+
+    assert(table);
+    p = find_bytes(table, bytes, len, &hash_val);
+    return p ? p->value : NULL;
+}
+
+void *table_put_bytes(T table, const char *bytes, int len, void *value,
+                      const char *newkey(const char *str, int len))
+{
+    int hash_val;
+    struct binding *p;
+    void *prev = NULL;
+
+    assert(table);
+    assert(newkey);
+    assert(table->value_size == 0);
+
+    p = find_bytes(table, bytes, len, &hash_val);
+    if (p == NULL) {
+        p = bind(table, newkey(bytes, len), hash_val);
+    } else {
+        prev = p->value;
+    }
+    p->value = value;
+    table->timestamp ++;
+    return prev;
+}
+
+void *table_slot_bytes(T table, const char *bytes, int len,
+                       const char *newkey(const char *str, int len))
+{
+    int hash_val;
+    struct binding *p;
+
+    assert(table);
+    assert(newkey);
+    assert(table->value_size > 0);
+
+    p = find_bytes(table, bytes, len, &hash_val);
+    if (p == NULL) {
+        p = bind(table, newkey(bytes, len), hash_val);
+        table->timestamp ++;
+    }
+    return p->value;
+}
+
+/* hash keys[0..n-1] and bring their bucket heads into cache, the bucket
+ * indexes are stored in *hash_vals*. If *filter*, keys rejected by the bloom
+ * filter get -1 instead */
+static void prefetch_buckets(T table, const void *keys[], int n,
+                             int hash_vals[], bool filter)
+{
+    unsigned hash;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        assert(keys[i]);
+        hash = (*table->hash)(keys[i]);
+        if (filter && !bloom_test(table->bloom, hash)) {
+            hash_vals[i] = -1;
+            continue;
+        }
+        hash_vals[i] = hash % table->size;
+        __builtin_prefetch(&table->buckets[hash_vals[i]]);
+    }
+    for (i = 0; i < n; i++) {
+        if (hash_vals[i] >= 0 && table->buckets[hash_vals[i]]) {
+            __builtin_prefetch(table->buckets[hash_vals[i]]);
+        }
+    }
+}
+
+void table_get_batch(T table, const void *keys[], int n, void *values[])
+{
+    int hash_vals[BATCH];
+    int i, j, m;
+    struct binding *p;
+
+    assert(table);
+    assert(n >= 0);
+    assert(keys && values);
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < BATCH) ? n - i : BATCH;
+        prefetch_buckets(table, keys + i, m, hash_vals, table->bloom != NULL);
+
+        for (j = 0; j < m; j++) {
+            if (hash_vals[j] < 0) {
+                values[i+j] = NULL;
+                continue;
+            }
+            for (p = table->buckets[hash_vals[j]]; p; p = p->link) {
+                if ((*table->cmp)(keys[i+j], p->key) == 0) {
+                    break;
+                }
+            }
+            if (p == NULL && table->bloom) {
+                bloom_false_positive(table->bloom);
+            }
+            values[i+j] = p ? p->value : NULL;
+        }
+    }
+}
+
+void table_put_batch(T table, const void *keys[], void *values[], int n,
+                     void *prevs[])
+{
+    int hash_vals[BATCH];
+    int i, j, m;
+    struct binding *p;
+    void *prev;
+
+    assert(table);
+    assert(n >= 0);
+    assert(keys && values);
+    assert(table->value_size == 0);
+
+    /* grow first, the hashes of a batch must stay valid */
+    if (is_small(table) && table->length + n > SMALL) {
+        resize(table, bucket_count(table->length + n));
+    }
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < BATCH) ? n - i : BATCH;
+        /* a key earlier in the batch may be bound after the filter was
+         * tested, its rejection would be stale */
+        prefetch_buckets(table, keys + i, m, hash_vals, false);
+
+        /* resolve in order, a key repeated in the batch finds the binding
+         * added by its first occurrence */
+        for (j = 0; j < m; j++) {
+            for (p = table->buckets[hash_vals[j]]; p; p = p->link) {
+                if ((*table->cmp)(keys[i+j], p->key) == 0) {
+                    break;
+                }
+            }
+
+            if (p == NULL) {
+                p = bind(table, keys[i+j], hash_vals[j]);
+                prev = NULL;
+            } else {
+                prev = p->value;
+            }
+            p->value = values[i+j];
+            if (prevs) {
+                prevs[i+j] = prev;
+            }
+        }
+    }
+    table->timestamp ++;
+}
+
 int table_length(T table)
 {
     assert(table);
     return table->length;
 }
 
+int (*table_cmp(T table))(const void *a, const void *b)
+{
+    assert(table);
+    return table->cmp;
+}
+
+unsigned (*table_hash(T table))(const void *key)
+{
+    assert(table);
+    return table->hash;
+}
+
 void table_map(T table, 
                void apply(const void *key, void **value, void *cl),
                void *cl)
@@ -135,13 +530,200 @@ void table_map(T table,
     timestamp = table->timestamp;
 
     for (i = 0; i < table->size; i++) {
+        prefetch_ahead(table, i);
         for (p=table->buckets[i]; p; p = p->link) {
+            __builtin_prefetch(p->link);
             assert(table->timestamp == timestamp);
             apply(p->key, &p->value, cl);
         }
     }
 }
 
+/* the share of a worker in table_map_parallel */
+struct worker {
+    T table;
+    int lo, hi;             /* buckets [lo, hi) */
+    void (*apply)(const void *key, void **value, void *wcl);
+    void *wcl;
+};
+
+static void *map_range(void *arg)
+{
+    struct worker *w = arg;
+    unsigned timestamp = w->table->timestamp;
+    struct binding *p;
+    int i;
+
+    for (i = w->lo; i < w->hi; i++) {
+        for (p = w->table->buckets[i]; p; p = p->link) {
+            assert(w->table->timestamp == timestamp);
+            w->apply(p->key, &p->value, w->wcl);
+        }
+    }
+    (void)timestamp;
+    return NULL;
+}
+
+void table_map_parallel(T table, int nworkers,
+                        void apply(const void *key, void **value, void *wcl),
+                        void *wcl[],
+                        void reduce(void *wcl, void *cl), void *cl)
+{
+    struct worker *workers;
+    pthread_t *tids;
+    int i;
+
+    assert(table);
+    assert(apply);
+    assert(nworkers > 0);
+
+    workers = zalloc(nworkers * sizeof(*workers));
+    tids = zalloc(nworkers * sizeof(*tids));
+    for (i = 0; i < nworkers; i++) {
+        workers[i].table = table;
+        workers[i].lo = (long)table->size * i / nworkers;
+        workers[i].hi = (long)table->size * (i + 1) / nworkers;
+        workers[i].apply = apply;
+        workers[i].wcl = wcl ? wcl[i] : NULL;
+    }
+
+    /* the calling thread takes the last range itself */
+    for (i = 0; i < nworkers - 1; i++) {
+        if (pthread_create(&tids[i], NULL, map_range, &workers[i]) != 0) {
+            map_range(&workers[i]);
+            tids[i] = pthread_self();
+        }
+    }
+    map_range(&workers[nworkers - 1]);
+    for (i = 0; i < nworkers - 1; i++) {
+        if (!pthread_equal(tids[i], pthread_self())) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+
+    if (reduce) {
+        for (i = 0; i < nworkers; i++) {
+            reduce(workers[i].wcl, cl);
+        }
+    }
+    zfree(tids);
+    zfree(workers);
+}
+
+void table_merge(T dst, T src,
+                 void *reduce(const void *key, void *dst_value,
+                              void *src_value, void *cl),
+                 void *cl)
+{
+    int i, hash_val;
+    struct binding *p, *q, *d;
+
+    assert(dst && src);
+    assert(dst != src);
+    assert(dst->cmp == src->cmp && dst->hash == src->hash);
+    assert(dst->value_size == src->value_size);
+
+    if (is_small(dst) && dst->length + src->length > SMALL) {
+        resize(dst, bucket_count(dst->length + src->length));
+    }
+
+    for (i = 0; i < src->size; i++) {
+        for (p = src->buckets[i]; p; p = q) {
+            q = p->link;
+            hash_val = (*dst->hash)(p->key) % dst->size;
+            for (d = dst->buckets[hash_val]; d; d = d->link) {
+                if ((*dst->cmp)(p->key, d->key) == 0) {
+                    break;
+                }
+            }
+
+            if (d == NULL) {
+                /* an inline value stays right after its binding */
+                p->link = dst->buckets[hash_val];
+                dst->buckets[hash_val] = p;
+                dst->length ++;
+                if (dst->bloom) {
+                    bloom_add(dst->bloom, (*dst->hash)(p->key));
+                }
+                continue;
+            }
+
+            if (dst->value_size) {
+                if (reduce) {
+                    reduce(d->key, d->value, p->value, cl);
+                } else {
+                    memcpy(d->value, p->value, dst->value_size);
+                }
+            } else {
+                d->value = reduce ? reduce(d->key, d->value, p->value, cl)
+                                  : p->value;
+            }
+            unbind(src, p);
+        }
+        src->buckets[i] = NULL;
+    }
+
+    src->length = 0;
+    src->timestamp ++;
+    dst->timestamp ++;
+}
+
+/* one merge of table_merge_tree */
+struct merge {
+    T dst, src;
+    void *(*reduce)(const void *key, void *dst_value, void *src_value,
+                    void *cl);
+    void *cl;
+};
+
+static void *merge_pair(void *arg)
+{
+    struct merge *m = arg;
+    table_merge(m->dst, m->src, m->reduce, m->cl);
+    return NULL;
+}
+
+void table_merge_tree(T tables[], int n,
+                      void *reduce(const void *key, void *dst_value,
+                                   void *src_value, void *cl),
+                      void *cl)
+{
+    struct merge *merges;
+    pthread_t *tids;
+    int step, i, k;
+
+    assert(tables);
+    assert(n > 0);
+
+    merges = zalloc(n * sizeof(*merges));
+    tids = zalloc(n * sizeof(*tids));
+    for (step = 1; step < n; step <<= 1) {
+        for (i = 0, k = 0; i + step < n; i += 2 * step, k++) {
+            merges[k].dst = tables[i];
+            merges[k].src = tables[i + step];
+            merges[k].reduce = reduce;
+            merges[k].cl = cl;
+        }
+
+        /* the last merge of a round runs on the calling thread */
+        for (i = 0; i < k - 1; i++) {
+            if (pthread_create(&tids[i], NULL, merge_pair, &merges[i]) != 0) {
+                merge_pair(&merges[i]);
+                tids[i] = pthread_self();
+            }
+        }
+        merge_pair(&merges[k - 1]);
+        for (i = 0; i < k - 1; i++) {
+            if (!pthread_equal(tids[i], pthread_self())) {
+                pthread_join(tids[i], NULL);
+            }
+        }
+    }
+
+    zfree(tids);
+    zfree(merges);
+}
+
 void *table_remove(T table, const void *key)
 {
     int hash_val;
@@ -157,9 +739,9 @@ void *table_remove(T table, const void *key)
     for (pp=&table->buckets[hash_val]; *pp; pp = &(*pp)->link) {
         if ((*table->cmp)(key, (*pp)->key) == 0) {
             struct binding *p = *pp;
-            value = p->value;
+            value = table->value_size ? NULL : p->value;
             *pp = p->link;
-            zfree(p);
+            unbind(table, p);
 
             table->length --;
             return value;
@@ -178,7 +760,9 @@ void **table_to_array(T table, void *end)
     assert(table);
     array = (void **)zalloc((2*table->length + 1) * sizeof (*array));
     for (i = 0; i < table->size; i++) {
+        prefetch_ahead(table, i);
         for (p=table->buckets[i]; p; p=p->link) {
+            __builtin_prefetch(p->link);
             array[j++] = (void *)p->key;
             array[j++] = (void *)p->value;
         }
@@ -204,10 +788,72 @@ void table_free(T *table, void (*destroy)(const void *key, void *data))
             }
         }
     }
+    trim_spare(*table, 0);
+    if ((*table)->bloom) {
+        bloom_free(&(*table)->bloom);
+    }
+    if (!is_small(*table)) {
+        zfree((*table)->buckets);
+    }
     zfree(*table);
     *table = NULL;
 }
 
+long table_memory_usage(T table)
+{
+    assert(table);
+    return sizeof(*table)
+        + (is_small(table) ? 0 : (long)table->size * sizeof(table->buckets[0]))
+        + ((long)table->length + table->nspare)
+          * (sizeof(struct binding) + table->value_size)
+        + (table->bloom ? bloom_memory_usage(table->bloom) : 0);
+}
+
+bloom_t table_bloom(T table, int expected)
+{
+    struct binding *p;
+    int i;
+
+    assert(table);
+    assert(expected >= 0);
+
+    if (table->bloom) {
+        bloom_free(&table->bloom);
+    }
+    if (expected == 0) {
+        return NULL;
+    }
+
+    table->bloom = bloom_new(expected > table->length ? expected
+                                                      : table->length);
+    for (i = 0; i < table->size; i++) {
+        for (p = table->buckets[i]; p; p = p->link) {
+            bloom_add(table->bloom, (*table->hash)(p->key));
+        }
+    }
+    return table->bloom;
+}
+
+void table_recycle(T table, int cap)
+{
+    assert(table);
+    assert(cap >= 0);
+    table->max_spare = cap;
+    trim_spare(table, cap);
+}
+
+void table_shrink_to_fit(T table)
+{
+    int size;
+
+    assert(table);
+    trim_spare(table, 0);
+    size = (table->length <= SMALL) ? 1 : bucket_count(table->length);
+    if (size < table->size) {
+        resize(table, size);
+    }
+}
+
 extern void print_table(T table)
 {
     assert(table);
@@ -4,13 +4,16 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include "bloom.h"
+
 /* this time, we hide the details about table_t, put it in the implementation.
  * */
 #define T table_t
 typedef struct T *T;
 
 /** @brief: create a new table 
- * @param hint: the size of the table.
+ * @param hint: the size of the table. A table created with a hint of a few
+ * bindings allocates its buckets only once it grows past them.
  * @param cmp: the function used to compare elements of the table.
  * @param hash: hash function used to generate hash value from *key* 
  * @return a pointer to the new table. 
@@ -19,6 +22,20 @@ extern T table_new(int hint,
                    int cmp(const void *a, const void *b),
                    unsigned hash(const void *key));
 
+/** @brief: create a new table whose values are stored inside the bindings
+ * @param value_size: the size in bytes of every value, must be positive.
+ * @return a pointer to the new table.
+ * Values of such a table are accessed through *table_slot*, *table_get*
+ * returns a pointer to the value's storage instead of a stored pointer, and
+ * *table_put* is not allowed. The pointers handed to *table_map* and the
+ * *destroy* function of *table_free* also point to the storage, they must
+ * not be reassigned.
+ */
+extern T table_new_inline(int hint,
+                          int cmp(const void *a, const void *b),
+                          unsigned hash(const void *key),
+                          int value_size);
+
 /** @brief: free a table
  * @param table: table to be freed
  * @param destroy: the function used to destroy an element, can be NULL.
@@ -36,6 +53,12 @@ extern void table_free(T *table, void (*destroy)(const void *key, void *value));
  */
 extern int table_length(T table);
 
+/** @brief: return the compare and hash functions of *table*, the default
+ * ones if NULL was given to *table_new*
+ */
+extern int (*table_cmp(T table))(const void *a, const void *b);
+extern unsigned (*table_hash(T table))(const void *key);
+
 /** @brief: search for a key and if it finds it, change the associated value.
  * If the key is not found, it allocates and initializes a new binding.
  * @param table: the table to be operated on
@@ -45,6 +68,43 @@ extern int table_length(T table);
  */
 void *table_put(T table, const void *key, void *value);
 
+/** @brief: return the storage of *key*'s value in an inline table.
+ * If the key is not found, a new binding is added with its value zeroed.
+ * @param table: a table created by *table_new_inline*
+ * @param key: the key to search
+ * @return a pointer to *value_size* bytes owned by the table, valid until the
+ * key is removed.
+ */
+extern void *table_slot(T table, const void *key);
+
+/** @brief: hash and compare functions for tables keyed by null-terminated
+ * strings, atoms for instance. Only tables created with *table_hash_string*
+ * can be searched by byte slices with the functions below.
+ */
+extern unsigned table_hash_string(const void *key);
+extern int table_cmp_string(const void *a, const void *b);
+
+/** @brief: like *table_get*, but the key is given as *len* bytes that need
+ * not be null-terminated nor be a key themselves. The keys of the table are
+ * compared to the bytes directly.
+ * @param bytes: the content of the key, it should not contain '\0'.
+ * @param len: the number of bytes
+ */
+extern void *table_get_bytes(T table, const char *bytes, int len);
+
+/** @brief: like *table_put*, but the key is given as a byte slice.
+ * @param newkey: only called when the key is not found, it returns the key
+ * to store for bytes[0..len-1], *atom_new* for instance.
+ */
+extern void *table_put_bytes(T table, const char *bytes, int len, void *value,
+                             const char *newkey(const char *str, int len));
+
+/** @brief: like *table_slot*, but the key is given as a byte slice, see
+ * *table_put_bytes* for *newkey*.
+ */
+extern void *table_slot_bytes(T table, const char *bytes, int len,
+                              const char *newkey(const char *str, int len));
+
 /** @brief: get the value of a given *key* in the *table*
  * @param table: the table from which we will get the value.
  * @param key: the key string
@@ -53,10 +113,28 @@ void *table_put(T table, const void *key, void *value);
  */
 extern void *table_get(T table, const void *key);
 
+/** @brief: get the values of *n* keys at once.
+ * All keys are hashed and their buckets prefetched before any chain is
+ * searched, so the cache misses of different keys overlap.
+ * @param keys: the keys to search
+ * @param n: the number of keys
+ * @param values: receives the value of keys[i] in values[i], NULL if not
+ * found.
+ */
+extern void table_get_batch(T table, const void *keys[], int n,
+                            void *values[]);
+
+/** @brief: put *n* bindings at once, same as calling *table_put* on
+ * (keys[i], values[i]) in order.
+ * @param prevs: receives the previous values, can be NULL.
+ */
+extern void table_put_batch(T table, const void *keys[], void *values[], int n,
+                            void *prevs[]);
+
 /** @brief: remove a table entry indexed by *key*
  * @param table: the table to be operated on
  * @param key: the key string
- * @return the previously stored value.
+ * @return the previously stored value, always NULL for inline tables.
  */
 extern void *table_remove(T table, const void *key);
 
@@ -68,6 +146,46 @@ extern void table_map(T table,
                       void apply(const void *key, void **value, void *cl),
                       void *cl);
 
+/* @brief: map the function *apply* over all elements in the table, using
+ * *nworkers* threads. The buckets are split into *nworkers* ranges, worker i
+ * visits range i and passes wcl[i] to *apply*, so that each worker can
+ * accumulate into its own closure. As for *table_map*, *apply* may change
+ * the values but not the table.
+ * @param wcl: the per-worker closures, *nworkers* of them, can be NULL.
+ * @param reduce: called as reduce(wcl[i], cl) for every worker in order, on
+ * the calling thread once all workers are done. Can be NULL.
+ * @return void
+ */
+extern void table_map_parallel(T table, int nworkers,
+                               void apply(const void *key, void **value,
+                                          void *wcl),
+                               void *wcl[],
+                               void reduce(void *wcl, void *cl), void *cl);
+
+/** @brief: move all bindings of *src* into *dst*, *src* is left empty.
+ * Bindings are relinked, not reallocated. Both tables must use the same
+ * *cmp*, *hash* and value size.
+ * @param reduce: called when *key* is in both tables, it returns the value
+ * *dst* keeps. If NULL, the value of *src* is kept. For inline tables both
+ * values point to the storage, *reduce* should combine *src_value* into
+ * *dst_value* and its result is ignored.
+ * @param cl: the client-specific pointer passed to *reduce*
+ */
+extern void table_merge(T dst, T src,
+                        void *reduce(const void *key, void *dst_value,
+                                     void *src_value, void *cl),
+                        void *cl);
+
+/** @brief: merge *n* tables into tables[0] as a tree: in each round table
+ * i + step is merged into table i on its own thread, for step = 1, 2, 4...
+ * All other tables are left empty, but not freed. *reduce* may be called
+ * from several threads at the same time.
+ */
+extern void table_merge_tree(T tables[], int n,
+                             void *reduce(const void *key, void *dst_value,
+                                          void *src_value, void *cl),
+                             void *cl);
+
 /** @brief: convert a table to an array, it will store the (key, value) pairs.
  * for example table["key"] = "value", then on the returned array, there will
  * be an index: array[i]="key", array[i+1] = "value"
@@ -77,6 +195,42 @@ extern void table_map(T table,
  */
 extern void **table_to_array(T table, void *end);
     
+/** @brief: return the number of bytes used by the table: the table itself,
+ * its buckets, its bindings (with their inline values) and the spare ones.
+ * Keys and values stored by pointer are not counted.
+ */
+extern long table_memory_usage(T table);
+
+/** @brief: put a Bloom filter in front of *table_get*, *table_get_batch* and
+ * the *_bytes* functions, so that most lookups of absent keys return without
+ * walking a chain. The filter is fed by every later put; removed keys stay
+ * in it, call *table_bloom* again to rebuild it from the current keys, for
+ * instance after many removals or once the table grows well past *expected*.
+ *
+ * The filter costs one more cache line read per lookup. It pays off when
+ * most lookups miss and a chain walk costs more than that: keys compared by
+ * content such as strings, or chains out of cache. A table whose lookups
+ * mostly hit, or whose keys are cheap to compare, is slower with it.
+ * @param expected the number of keys to size the filter for, at least the
+ * current length is used. 0 removes the filter.
+ * @return the filter, owned by the table, whose counters can be turned on
+ * with *bloom_count* and read with *bloom_stats*. NULL if *expected* is 0.
+ */
+extern bloom_t table_bloom(T table, int expected);
+
+/** @brief: keep up to *cap* removed bindings for reuse by later puts, so a
+ * table whose size stays steady under put/remove churn stops calling the
+ * allocator. The default *cap* is 0, spare bindings beyond a new *cap* are
+ * freed.
+ */
+extern void table_recycle(T table, int cap);
+
+/** @brief: reduce the number of buckets to what *table_new* would choose for
+ * the current length, returning the rest to the allocator, spare bindings
+ * kept by *table_recycle* included. Useful after many *table_remove*.
+ */
+extern void table_shrink_to_fit(T table);
+
 /* debug function */
 extern void print_table(T table);
 #undef T
@@ -0,0 +1,363 @@
+/* implementation of *vtable*
+ */
+#include <limits.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "vtable.h"
+#include "mem.h"
+
+#define T vtable_t
+
+/* buckets per page */
+#define PAGE 64
+
+/* the directory doubles when the bindings outnumber its buckets by this */
+#define MAX_LOAD 2
+
+/* A page owns the bindings of its buckets. Directories and pages are
+ * reference counted, a count above one means shared, hence read-only.
+ *
+ *   table ---> dir ---> page ---> buckets ---> bindings
+ *   snapshot --^  \---> page ...
+ */
+struct page {
+    int refcount;
+    struct binding {
+        struct binding *link;
+        const void *key;
+        void *value;
+    } *buckets[PAGE];
+};
+
+struct dir {
+    int refcount;
+    int length;
+    int npages;
+    struct page *pages[];
+};
+
+struct T {
+    struct dir *dir;
+    int readonly;
+    unsigned timestamp;     /* used in vtable_map to indicate that table
+                               should not change while doing *map* */
+    int (*cmp)(const void *a, const void *b);
+    unsigned (*hash)(const void *key);
+};
+
+static unsigned default_hash(const void *key)
+{
+    return (unsigned long)key >> 2;
+}
+
+static int default_cmp(const void *a, const void *b)
+{
+    return a != b;
+}
+
+static inline int shared(int *refcount)
+{
+    return __atomic_load_n(refcount, __ATOMIC_ACQUIRE) > 1;
+}
+
+static void release_page(struct page *page)
+{
+    int i;
+    struct binding *p, *q;
+
+    if (__atomic_sub_fetch(&page->refcount, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    for (i = 0; i < PAGE; i++) {
+        for (p = page->buckets[i]; p; p = q) {
+            q = p->link;
+            zfree(p);
+        }
+    }
+    zfree(page);
+}
+
+static void release_dir(struct dir *dir)
+{
+    int i;
+
+    if (__atomic_sub_fetch(&dir->refcount, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    for (i = 0; i < dir->npages; i++) {
+        release_page(dir->pages[i]);
+    }
+    zfree(dir);
+}
+
+T vtable_new(int hint,
+             int cmp(const void *a, const void *b),
+             unsigned hash(const void *key))
+{
+    T table;
+    struct dir *dir;
+    int i, npages;
+
+    assert(hint >= 0);
+    npages = (hint + PAGE - 1) / PAGE;
+    npages = npages < 8 ? 8 : npages;
+
+    dir = zalloc(sizeof(*dir) + npages * sizeof(dir->pages[0]));
+    dir->refcount = 1;
+    dir->length = 0;
+    dir->npages = npages;
+    for (i = 0; i < npages; i++) {
+        dir->pages[i] = zcalloc(1, sizeof(struct page));
+        dir->pages[i]->refcount = 1;
+    }
+
+    table = (T)zalloc(sizeof(*table));
+    table->dir = dir;
+    table->readonly = 0;
+    table->timestamp = 0;
+    table->cmp = cmp ? cmp : default_cmp;
+    table->hash = hash ? hash : default_hash;
+
+    return table;
+}
+
+void vtable_free(T *table)
+{
+    assert(table && *table);
+    release_dir((*table)->dir);
+    zfree(*table);
+    *table = NULL;
+}
+
+T vtable_snapshot(T table)
+{
+    T snap;
+
+    assert(table);
+    __atomic_add_fetch(&table->dir->refcount, 1, __ATOMIC_RELAXED);
+
+    snap = (T)zalloc(sizeof(*snap));
+    *snap = *table;
+    snap->readonly = 1;
+    return snap;
+}
+
+int vtable_length(T table)
+{
+    assert(table);
+    return table->dir->length;
+}
+
+/* the bucket of *key*, as bucket index *i* of page *pi* */
+static inline void locate(T table, const void *key, int *pi, int *i)
+{
+    unsigned h = (*table->hash)(key) % ((unsigned)table->dir->npages * PAGE);
+    *pi = h / PAGE;
+    *i = h % PAGE;
+}
+
+/* make the directory and page *pi* private to *table*, copying them if
+ * they are shared with a snapshot */
+static struct page *own_page(T table, int pi)
+{
+    struct dir *dir = table->dir;
+    struct page *page;
+    struct binding *p, **pp;
+    int i;
+
+    if (shared(&dir->refcount)) {
+        struct dir *copy;
+        copy = zalloc(sizeof(*copy) + dir->npages * sizeof(copy->pages[0]));
+        copy->refcount = 1;
+        copy->length = dir->length;
+        copy->npages = dir->npages;
+        for (i = 0; i < dir->npages; i++) {
+            copy->pages[i] = dir->pages[i];
+            __atomic_add_fetch(&copy->pages[i]->refcount, 1, __ATOMIC_RELAXED);
+        }
+        release_dir(dir);
+        table->dir = dir = copy;
+    }
+
+    page = dir->pages[pi];
+    if (shared(&page->refcount)) {
+        struct page *copy = zalloc(sizeof(*copy));
+        copy->refcount = 1;
+        for (i = 0; i < PAGE; i++) {
+            pp = &copy->buckets[i];
+            for (p = page->buckets[i]; p; p = p->link) {
+                *pp = zalloc(sizeof(**pp));
+                **pp = *p;
+                pp = &(*pp)->link;
+            }
+            *pp = NULL;
+        }
+        release_page(page);
+        dir->pages[pi] = page = copy;
+    }
+    return page;
+}
+
+/* rehash *table* into a directory of twice as many pages. Bindings are
+ * moved out of private pages and copied out of shared ones, so the old
+ * directory stays intact for the snapshots that hold it. */
+static void grow(T table)
+{
+    struct dir *dir = table->dir, *bigger;
+    struct page *page;
+    struct binding *p, *q, *b;
+    int i, j, pi, bi, npages, private, move;
+    unsigned h;
+
+    if (dir->npages > INT_MAX / PAGE / 2) {
+        return;
+    }
+    npages = dir->npages * 2;
+    bigger = zalloc(sizeof(*bigger) + npages * sizeof(bigger->pages[0]));
+    bigger->refcount = 1;
+    bigger->length = dir->length;
+    bigger->npages = npages;
+    for (i = 0; i < npages; i++) {
+        bigger->pages[i] = zcalloc(1, sizeof(struct page));
+        bigger->pages[i]->refcount = 1;
+    }
+
+    private = !shared(&dir->refcount);
+    for (i = 0; i < dir->npages; i++) {
+        page = dir->pages[i];
+        move = private && !shared(&page->refcount);
+        for (j = 0; j < PAGE; j++) {
+            for (p = page->buckets[j]; p; p = q) {
+                q = p->link;
+                if (move) {
+                    b = p;
+                } else {
+                    b = zalloc(sizeof(*b));
+                    *b = *p;
+                }
+                h = (*table->hash)(b->key) % ((unsigned)npages * PAGE);
+                pi = h / PAGE;
+                bi = h % PAGE;
+                b->link = bigger->pages[pi]->buckets[bi];
+                bigger->pages[pi]->buckets[bi] = b;
+            }
+            if (move) {
+                page->buckets[j] = NULL;
+            }
+        }
+    }
+    release_dir(dir);
+    table->dir = bigger;
+}
+
+void *vtable_get(T table, const void *key)
+{
+    struct binding *p;
+    int pi, i;
+
+    assert(table);
+    assert(key);
+
+    locate(table, key, &pi, &i);
+    for (p = table->dir->pages[pi]->buckets[i]; p; p = p->link) {
+        if ((*table->cmp)(key, p->key) == 0) {
+            return p->value;
+        }
+    }
+    return NULL;
+}
+
+void *vtable_put(T table, const void *key, void *value)
+{
+    struct page *page;
+    struct binding *p;
+    void *prev;
+    int pi, i;
+
+    assert(table);
+    assert(key);
+    assert(!table->readonly);
+
+    if (table->dir->length >= (long)MAX_LOAD * table->dir->npages * PAGE) {
+        grow(table);
+    }
+    locate(table, key, &pi, &i);
+    page = own_page(table, pi);
+    for (p = page->buckets[i]; p; p = p->link) {
+        if ((*table->cmp)(key, p->key) == 0) {
+            break;
+        }
+    }
+
+    if (p == NULL) {
+        p = zalloc(sizeof(*p));
+        p->key = key;
+        p->link = page->buckets[i];
+        page->buckets[i] = p;
+        table->dir->length ++;
+        prev = NULL;
+    } else {
+        prev = p->value;
+    }
+    p->value = value;
+    table->timestamp ++;
+    return prev;
+}
+
+void *vtable_remove(T table, const void *key)
+{
+    struct page *page;
+    struct binding **pp, *p;
+    void *value;
+    int pi, i;
+
+    assert(table);
+    assert(key);
+    assert(!table->readonly);
+
+    /* do not copy a page for a key it does not hold */
+    if (vtable_get(table, key) == NULL) {
+        return NULL;
+    }
+
+    locate(table, key, &pi, &i);
+    page = own_page(table, pi);
+    for (pp = &page->buckets[i]; *pp; pp = &(*pp)->link) {
+        if ((*table->cmp)(key, (*pp)->key) == 0) {
+            p = *pp;
+            *pp = p->link;
+            value = p->value;
+            zfree(p);
+            table->dir->length --;
+            table->timestamp ++;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+void vtable_map(T table,
+                void apply(const void *key, void *value, void *cl),
+                void *cl)
+{
+    struct dir *dir;
+    struct binding *p;
+    unsigned timestamp;
+    int pi, i;
+
+    assert(table);
+    assert(apply);
+    timestamp = table->timestamp;
+    dir = table->dir;
+
+    for (pi = 0; pi < dir->npages; pi++) {
+        for (i = 0; i < PAGE; i++) {
+            for (p = dir->pages[pi]->buckets[i]; p; p = p->link) {
+                apply(p->key, p->value, cl);
+                assert(table->timestamp == timestamp);
+            }
+        }
+    }
+    (void)timestamp;
+}
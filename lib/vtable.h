@@ -0,0 +1,68 @@
+/** @file vtable.h
+ * @brief a table with cheap read-only snapshots.
+ *
+ * vtable has the same key/value semantics as *table*. In addition,
+ * *vtable_snapshot* returns a frozen view of the table in constant time,
+ * which other threads can read and iterate while the owner keeps updating
+ * the table.
+ *
+ * The buckets are grouped into pages of 64 buckets, and the pages are
+ * reached through a directory. A snapshot only shares the directory. The
+ * first update after a snapshot copies the directory, and every page is
+ * copied, together with its bindings, the first time it is written while
+ * still shared. Pages that are never written stay shared. When the
+ * bindings outnumber the buckets twice over, the table moves to a directory
+ * of twice as many pages, copying only the bindings a snapshot still holds.
+ *
+ * Keys and values are shared by all versions and never freed by vtable.
+ */
+#ifndef VTABLE_H
+#define VTABLE_H
+
+#define T vtable_t
+typedef struct T *T;
+
+/** @brief create a new table
+ * @param hint the estimated number of entries.
+ * @param cmp, hash same as *table_new*, NULL for the defaults.
+ */
+extern T vtable_new(int hint,
+                    int cmp(const void *a, const void *b),
+                    unsigned hash(const void *key));
+
+/** @brief free a table or a snapshot, other versions are not affected.
+ * A snapshot can be freed by any thread.
+ */
+extern void vtable_free(T *table);
+
+/** @brief return a read-only snapshot of *table*.
+ * Taking a snapshot of a writable table must not run at the same time as an
+ * update of that table, call it from the writer thread for instance.
+ * Snapshots of snapshots can be taken from any thread.
+ */
+extern T vtable_snapshot(T table);
+
+/** @brief return the number of bindings */
+extern int vtable_length(T table);
+
+/** @brief bind *value* to *key*, *table* should not be a snapshot
+ * @return the previous value, NULL if *key* was not found.
+ */
+extern void *vtable_put(T table, const void *key, void *value);
+
+/** @brief return the value of *key*, NULL if not found */
+extern void *vtable_get(T table, const void *key);
+
+/** @brief remove *key*, *table* should not be a snapshot
+ * @return the removed value, NULL if not found.
+ */
+extern void *vtable_remove(T table, const void *key);
+
+/** @brief apply a function over all bindings, the table should not change
+ * while mapping. */
+extern void vtable_map(T table,
+                       void apply(const void *key, void *value, void *cl),
+                       void *cl);
+
+#undef T
+#endif /* end of include guard: VTABLE_H */
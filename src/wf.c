@@ -26,31 +26,20 @@ int cmp(const void *a, const void *b)
     return strcmp(*(char **)a, *(char **)b);
 }
 
-void vfree(const void *key, void *val)
-{
-    (void)key;   /* key not used, supress warning */
-    zfree(val);
-}
-
 void wf(const char *name, FILE *fp) 
 {
-    table_t table = table_new(0, NULL, NULL);
+    table_t table = table_new_inline(0, table_cmp_string, table_hash_string,
+                                     sizeof(int));
     char buf[BUFSIZ];
 
     while (getword(fp, buf, sizeof(buf), first, rest)) {
-        const char *word;
         int i, *count;
         for (i=0; buf[i] != '\0'; i++)
             buf[i] = tolower(buf[i]);
-        word = atom_string(buf);
-        count = table_get(table, word);
-        if (count) {
-            (*count) ++;
-        } else {
-            count = (int *)zalloc(sizeof (*count));
-            *count = 1;
-            table_put(table, word, count);
-        }
+        /* the count is stored in the table, starts from zero. The word only
+         * becomes an atom the first time it is seen */
+        count = table_slot_bytes(table, buf, i, atom_new);
+        (*count) ++;
     }
 
     if (name) {
@@ -66,7 +55,7 @@ void wf(const char *name, FILE *fp)
     zfree(array);
 
     /* destroy the table */
-    table_free(&table, vfree);
+    table_free(&table, NULL);
 }
 
 int main(int argc, const char *argv[])
@@ -10,25 +10,30 @@
 #include <ctype.h>
 
 #include <atom.h>
-#include <table.h>
-#include <set.h>
+#include <ptable.h>
+#include <iset.h>
 #include <mem.h>
 
 #include "getword.h"
 
 /* Data structure of *xref*
  *
- * identifiers
- * +------+
- * |id x  |
- * +------+       files
- * |id y  | ---> +------+
- * +------+      |file 1| ---> set | 1 6 2 3 7 9 | 
- * |id t  |      +------+
- * +------+      |file 2| ---> set | 8 2 4 3 1 7 |
- * |      |      +------+
- * | ...  |      | ...  |
- * +------+      +------+
+ * one ptable keyed by the pair (identifier, file), both atoms, each
+ * holding the iset of the line numbers, kept sorted
+ *
+ *   refs
+ *   +---------------+
+ *   | (id x, file 1)| ---> iset | 1 2 3 6 7 9 |
+ *   +---------------+
+ *   | (id x, file 2)| ---> iset | 1 2 3 4 7 8 |
+ *   +---------------+
+ *   | (id y, file 1)| ---> iset | 5 |
+ *   +---------------+
+ *   | ...           |
+ *   +---------------+
+ *
+ * the output is grouped by sorting the (identifier, file, iset) triples of
+ * ptable_to_array
  */
 
 /* xref prototypes */
@@ -51,34 +56,22 @@ int rest(int c)
     return isalpha(c) || c == '_' || isdigit(c);
 }
 
-/* used to compare two identifiers(char *), used in qsort(identifiers ||
- * files)*/
+/* used to compare two identifiers or two files (char *) */
 int cmp(const void *a, const void *b)
 {
     return strcmp(*(char **)a, *(char **)b);
 }
 
-/* used in generate a new set, compare two integer pointers */
-int set_cmp_int(const void *a, const void *b)
-{
-    return *(int *)a - *(int *)b;
-}
-
-/* used in generate a new set, to generate a hash value from an integer
- * pointers */
-unsigned set_hash_int(const void *x)
+/* used in qsort() of the triples (identifier, file, set), sort by identifier
+ * and then by file */
+int cmp_ref(const void *a, const void *b)
 {
-    return *(int *)x;
-}
-
-/* used in qsort(), compare two pointers which points to pointer to integers */
-int cmp_int(const void *a, const void *b)
-{
-    return **(int **)a - **(int **)b;
+    int c = cmp(a, b);
+    return c ? c : cmp((char **)a + 1, (char **)b + 1);
 }
 
 /* build xref database */
-void xref(const char *name, FILE *fp, table_t identifiers)
+void xref(const char *name, FILE *fp, ptable_t refs)
 {
     char buf[BUFSIZ];
 
@@ -89,40 +82,26 @@ void xref(const char *name, FILE *fp, table_t identifiers)
     linenum = 1;
 
     while (getword(fp, buf, sizeof(buf), first, rest)) {
-        set_t set;
-        table_t files;
+        iset_t set;
         const char *id = atom_string(buf);
 
-        /* files <- file table in identifiers associated with id */
-        files = table_get(identifiers, id);
-        if (files == NULL) {
-            files = table_new(0, NULL, NULL);
-            table_put(identifiers, id, files);
-        }
-
-        /* set <- set in files associated with name */
-        set = table_get(files, name);
+        /* set <- set in refs associated with (id, name) */
+        set = ptable_get(refs, id, name);
         if (set == NULL) {
-            set = set_new(0, set_cmp_int, set_hash_int);
-            table_put(files, name, set);
+            set = iset_new();
+            ptable_put(refs, id, name, set);
         }
 
-        /* add linenum to set, if necessary */
-        int *p = &linenum;
-        if (!set_member(set, p)) {
-            p = (int *)zalloc(sizeof(*p));
-            *p = linenum;
-            set_put(set, p);
-        }
+        /* add linenum to set */
+        iset_put(set, linenum);
     }
 }
 
 
-void print_set(set_t set)
+void print_set(iset_t set)
 {
-    int i;
-    void **lines = set_to_array(set, NULL);
-    qsort(lines, set_length(set), sizeof(*lines), cmp_int);
+    unsigned long i, n = iset_length(set);
+    unsigned *lines = iset_to_array(set);   /* sorted */
 
     /*for (i=0; lines[i]; i++) {*/
         /*printf(" %d", *(int *)lines[i]);*/
@@ -130,66 +109,53 @@ void print_set(set_t set)
     /* join consecutive lines in the output 
      * 7 8 9 10 11 16 18 20 21 => 7-11 16 18 20-21*/
     char c = '\0'; /* the delimiter before numbers */
-    for (i = 1; lines[i]; i++) {
-        if (*(int *)lines[i] == *(int *)lines[i-1] + 1) {
+    for (i = 1; i < n; i++) {
+        if (lines[i] == lines[i-1] + 1) {
             if (c != '-') {
                 printf("%c", c);
-                printf("%d", *(int *)lines[i-1]);
+                printf("%u", lines[i-1]);
                 c = '-';
             }
             continue;
         } else {
             printf("%c", c);
-            printf("%d", *(int *)lines[i-1]);
+            printf("%u", lines[i-1]);
             c = ' ';
         }
     }
     printf("%c", c);
-    printf("%d", *(int *)lines[i-1]);
+    printf("%u", lines[i-1]);
     
     zfree(lines);
 }
 
-/* format and print a single entry of an identifier 
+/* format the output and print out all identifiers
  *
  * idenfier --> file 1 -> line 1 3 5 6 9
- *          --> file 2 -> line 18 28 3 13
+ *          --> file 2 -> line 3 13 18 28
  *          --> ...
  *
  * */
-void print_files(table_t files)
+void print_identifiers(ptable_t refs)
 {
     int i;
-    void ** array = table_to_array(files, NULL);
-
-    qsort(array, table_length(files), 2*sizeof(*array), cmp);
+    void **array = ptable_to_array(refs, NULL);
+    qsort(array, ptable_length(refs), 3*sizeof(*array), cmp_ref);
 
-    for (i=0; array[i]; i+=2) {
+    for (i=0; array[i]; i+=3) {
+        /* print the idenfier name once, before its first file */
+        if (i == 0 || array[i] != array[i-3]) {
+            printf("%s:\n", (char *)array[i]);
+        }
         /* check if a filename is vaid (!="") */
-        if (*(char *)array[i] != '\0') {
-            printf("\t%s:", (char *)array[i]);
+        if (*(char *)array[i+1] != '\0') {
+            printf("\t%s:", (char *)array[i+1]);
         }
-        /* print the line numbers in the set array[i+1] */
-        print_set((set_t)array[i+1]);
+        /* print the line numbers in the set array[i+2] */
+        print_set((iset_t)array[i+2]);
 
         printf("\n");
     }
-    zfree(array);
-}
-
-/* format the output and print out all identifiers */
-void print_identifiers(table_t identifiers)
-{
-    int i;
-    void **array = table_to_array(identifiers, NULL);
-    qsort(array, table_length(identifiers), 2*sizeof(*array), cmp);
-
-    for (i=0; array[i]; i+=2) {
-        /* print the idenfier name */
-        printf("%s:\n", (char *)array[i]);
-        /* print the files and lines with reference to this idenfier */
-        print_files((table_t) array[i+1]);
-    }
 
     zfree(array);   /* in lib/mem.h */
 }
@@ -197,7 +163,7 @@ void print_identifiers(table_t identifiers)
 int main(int argc, const char *argv[])
 {
     int i;
-    table_t identifiers = table_new(0, NULL, NULL);
+    ptable_t refs = ptable_new(0);
 
     for (i = 1; i < argc; i++) {
         FILE *fp = fopen(argv[i], "r");
@@ -205,16 +171,16 @@ int main(int argc, const char *argv[])
             fprintf(stderr, "%s: cannot open '%s' (%s)\n", argv[0], argv[i],
                     strerror(errno));
         } else {
-            xref(argv[i], fp, identifiers);
+            xref(argv[i], fp, refs);
             fclose(fp);
         }
     }
     if (argc == 1) {
-        xref(NULL, stdin, identifiers);
+        xref(NULL, stdin, refs);
     }
 
     /* print the identifiers */
-    print_identifiers(identifiers);
+    print_identifiers(refs);
 
     /* TODO: free the table */
 
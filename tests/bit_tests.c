@@ -76,6 +76,24 @@ char *test_set_clear_not()
     return NULL;
 }
 
+char *test_count()
+{
+    bit_t c = bit_new(8);
+    bit_t d = bit_new(100);
+
+    /* only bits of the first byte */
+    bit_put(c, 0, 1);
+    bit_put(c, 7, 1);
+    mu_assert(bit_count(c) == 2, "bit_count misses the first byte.\n");
+    bit_put(d, 3, 1);
+    bit_put(d, 99, 1);
+    mu_assert(bit_count(d) == 2, "bit_count misses a byte.\n");
+
+    bit_free(&c);
+    bit_free(&d);
+    return NULL;
+}
+
 char *test_compare()
 {
     bit_clear(a, 0, 255);
@@ -294,6 +312,7 @@ char *all_tests()
     mu_run_test(test_new);
     mu_run_test(test_put_get);
     mu_run_test(test_set_clear_not);
+    mu_run_test(test_count);
     mu_run_test(test_compare);
     mu_run_test(test_bit_operation);
 
@@ -0,0 +1,92 @@
+#include "minunit.h"
+#include <bloom.h>
+
+#define N 100000
+#define LARGE 4000000
+
+bloom_t bloom = NULL;
+
+char *test_new()
+{
+    bloom = bloom_new(N);
+    mu_assert(bloom != NULL, "bloom_new returned NULL.\n");
+    mu_assert(bloom_memory_usage(bloom) < N * 2,
+              "bloom_new takes more than 2 bytes per key.\n");
+    return NULL;
+}
+
+char *test_add_test()
+{
+    long queries, rejected, fps;
+    unsigned i;
+
+    /* even hashes are added, odd ones are not */
+    for (i = 0; i < 2 * N; i += 2) {
+        bloom_add(bloom, i * 2654435761U);
+    }
+
+    /* the counters are off until asked for */
+    bloom_test(bloom, 1);
+    bloom_false_positive(bloom);
+    bloom_stats(bloom, &queries, &rejected, &fps);
+    mu_assert(queries == 0 && rejected == 0 && fps == 0,
+              "bloom_test counts without bloom_count.\n");
+    bloom_count(bloom, true);
+    for (i = 0; i < 2 * N; i += 2) {
+        mu_assert(bloom_test(bloom, i * 2654435761U),
+                  "bloom_test misses an added key.\n");
+    }
+    for (i = 1; i < 2 * N; i += 2) {
+        if (bloom_test(bloom, i * 2654435761U)) {
+            bloom_false_positive(bloom);
+        }
+    }
+
+    bloom_stats(bloom, &queries, &rejected, &fps);
+    mu_assert(queries == 2 * N, "bloom_stats counts wrong queries.\n");
+    mu_assert(rejected + fps == N, "bloom_stats counts wrong outcomes.\n");
+    mu_assert(fps < N / 50, "bloom has too many false positives.\n");
+    return NULL;
+}
+
+char *test_large()
+{
+    bloom_t large = bloom_new(LARGE);
+    long fps = 0;
+    unsigned i;
+
+    /* with many blocks, the bits of a key still depend on more than its
+     * block */
+    for (i = 0; i < LARGE; i++) {
+        bloom_add(large, 2 * i * 2654435761U);
+    }
+    for (i = 0; i < LARGE / 4; i++) {
+        fps += bloom_test(large, (2 * i + 1) * 2654435761U);
+    }
+    mu_assert(fps < LARGE / 4 * 13 / 1000,
+              "a large bloom has too many false positives.\n");
+
+    bloom_free(&large);
+    return NULL;
+}
+
+char *test_free()
+{
+    bloom_free(&bloom);
+    mu_assert(bloom == NULL, "error when freeing bloom");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_add_test);
+    mu_run_test(test_large);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,130 @@
+#include "minunit.h"
+#include <cache.h>
+
+static int keys[] = {0,1,2,3,4,5,6,7,8,9};
+
+static int evicted[10];
+static int nevicted;
+
+void on_evict(const void *key, void *value, void *cl)
+{
+    (void)value;
+    (void)cl;
+    evicted[nevicted++] = *(int *)key;
+}
+
+char *test_lru()
+{
+    cache_t c = cache_new(3, 0, CACHE_LRU, NULL, NULL, on_evict, NULL);
+    long hits, misses, evictions;
+
+    nevicted = 0;
+    cache_put(c, &keys[0], &keys[0], 1);
+    cache_put(c, &keys[1], &keys[1], 1);
+    cache_put(c, &keys[2], &keys[2], 1);
+    mu_assert(cache_length(c) == 3, "cache_put gets wrong length.\n");
+
+    /* 0 becomes the most recent, 1 is the victim */
+    mu_assert(cache_get(c, &keys[0]) == &keys[0], "cache_get misses.\n");
+    cache_put(c, &keys[3], &keys[3], 1);
+    mu_assert(nevicted == 1 && evicted[0] == 1, "LRU evicts a wrong entry.\n");
+    mu_assert(cache_get(c, &keys[1]) == NULL, "evicted entry is found.\n");
+    mu_assert(cache_length(c) == 3, "cache exceeds its entry limit.\n");
+
+    /* replacing a value is not an eviction */
+    mu_assert(cache_put(c, &keys[2], &keys[5], 1) == &keys[2],
+              "cache_put returns wrong prev value.\n");
+    mu_assert(nevicted == 1, "replaced value is evicted.\n");
+    cache_put(c, &keys[4], &keys[4], 1);
+    mu_assert(nevicted == 2 && evicted[1] == 0, "LRU evicts a wrong entry.\n");
+
+    mu_assert(cache_remove(c, &keys[2]) == &keys[5],
+              "cache_remove returns wrong value.\n");
+    mu_assert(cache_length(c) == 2, "cache_remove gets wrong length.\n");
+
+    cache_stats(c, &hits, &misses, &evictions);
+    mu_assert(hits == 1 && misses == 1 && evictions == 2,
+              "cache_stats gets wrong counters.\n");
+
+    cache_free(&c, NULL);
+    mu_assert(c == NULL, "error when freeing cache.\n");
+    return NULL;
+}
+
+char *test_clock()
+{
+    cache_t c = cache_new(3, 0, CACHE_CLOCK, NULL, NULL, on_evict, NULL);
+
+    nevicted = 0;
+    cache_put(c, &keys[0], &keys[0], 1);
+    cache_put(c, &keys[1], &keys[1], 1);
+    cache_put(c, &keys[2], &keys[2], 1);
+
+    /* 0 and 1 get a second chance, 2 does not */
+    cache_get(c, &keys[0]);
+    cache_get(c, &keys[1]);
+    cache_put(c, &keys[3], &keys[3], 1);
+    mu_assert(nevicted == 1 && evicted[0] == 2, "CLOCK evicts a wrong entry.\n");
+    mu_assert(cache_get(c, &keys[0]) && cache_get(c, &keys[1])
+              && cache_get(c, &keys[3]), "CLOCK loses an entry.\n");
+
+    cache_free(&c, NULL);
+    return NULL;
+}
+
+char *test_bytes()
+{
+    cache_t c = cache_new(0, 100, CACHE_LRU, NULL, NULL, on_evict, NULL);
+
+    nevicted = 0;
+    cache_put(c, &keys[0], &keys[0], 40);
+    cache_put(c, &keys[1], &keys[1], 40);
+    mu_assert(cache_bytes(c) == 80, "cache_bytes is wrong.\n");
+    cache_put(c, &keys[2], &keys[2], 40);
+    mu_assert(nevicted == 1 && evicted[0] == 0, "byte limit is not kept.\n");
+    mu_assert(cache_bytes(c) == 80, "cache_bytes is wrong after eviction.\n");
+
+    cache_put(c, &keys[1], &keys[1], 10);
+    mu_assert(cache_bytes(c) == 50, "cache_bytes is wrong after replacing.\n");
+
+    cache_free(&c, NULL);
+    return NULL;
+}
+
+char *test_large()
+{
+    static int many[200000];
+    cache_t c = cache_new(0, 100000, CACHE_LRU, NULL, NULL, NULL, NULL);
+    long hits, misses, evictions;
+    int i;
+
+    /* a byte-bounded cache sizes its index from the live entries */
+    for (i = 0; i < 200000; i++) {
+        cache_put(c, &many[i], &many[i], 1);
+    }
+    mu_assert(cache_length(c) == 100000, "byte limit is not kept.\n");
+    for (i = 0; i < 200000; i++) {
+        mu_assert((cache_get(c, &many[i]) != NULL) == (i >= 100000),
+                  "cache_get gets wrong in a large cache.\n");
+    }
+    cache_stats(c, &hits, &misses, &evictions);
+    mu_assert(hits == 100000 && misses == 100000 && evictions == 100000,
+              "cache_stats is wrong in a large cache.\n");
+
+    cache_free(&c, NULL);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_lru);
+    mu_run_test(test_clock);
+    mu_run_test(test_bytes);
+    mu_run_test(test_large);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
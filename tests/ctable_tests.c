@@ -0,0 +1,124 @@
+#include "minunit.h"
+#include <ctable.h>
+#include <pthread.h>
+
+#define NTHREADS 4
+#define NKEYS 10000
+
+static int keys[NTHREADS * NKEYS];
+
+ctable_t tbl = NULL;
+
+char *test_new()
+{
+    tbl = ctable_new(0, NULL, NULL);
+    mu_assert(tbl != NULL, "ctable_new returned NULL.\n");
+    mu_assert(ctable_length(tbl) == 0, "the length of new table is not 0.\n");
+    return NULL;
+}
+
+char *test_put_get_remove()
+{
+    void *tmp;
+
+    tmp = ctable_put(tbl, &keys[0], &keys[0]);
+    mu_assert(tmp == NULL, "ctable_put returns value for a new key.\n");
+    tmp = ctable_put(tbl, &keys[0], &keys[1]);
+    mu_assert(tmp == &keys[0], "ctable_put returns wrong prev value.\n");
+    ctable_put(tbl, &keys[1], &keys[1]);
+    mu_assert(ctable_length(tbl) == 2, "ctable_put gets wrong length.\n");
+
+    tmp = ctable_get(tbl, &keys[0]);
+    mu_assert(tmp == &keys[1], "ctable_get gets wrong value.\n");
+    tmp = ctable_get(tbl, &keys[2]);
+    mu_assert(tmp == NULL, "ctable_get finds a key never inserted.\n");
+
+    tmp = ctable_remove(tbl, &keys[0]);
+    mu_assert(tmp == &keys[1], "ctable_remove returns wrong value.\n");
+    tmp = ctable_remove(tbl, &keys[0]);
+    mu_assert(tmp == NULL, "ctable_remove removes a key twice.\n");
+    mu_assert(ctable_length(tbl) == 1, "ctable_remove gets wrong length.\n");
+
+    ctable_remove(tbl, &keys[1]);
+    return NULL;
+}
+
+/* every thread puts and reads back its own range of keys */
+static void *worker(void *arg)
+{
+    int *base = arg;
+    int i;
+    for (i = 0; i < NKEYS; i++) {
+        ctable_put(tbl, &base[i], &base[i]);
+    }
+    for (i = 0; i < NKEYS; i++) {
+        if (ctable_get(tbl, &base[i]) != &base[i]) {
+            return "lost";
+        }
+    }
+    for (i = 0; i < NKEYS; i += 2) {
+        ctable_remove(tbl, &base[i]);
+    }
+    return NULL;
+}
+
+char *test_threads()
+{
+    pthread_t tid[NTHREADS];
+    void *ret;
+    int i;
+
+    for (i = 0; i < NTHREADS; i++) {
+        pthread_create(&tid[i], NULL, worker, &keys[i * NKEYS]);
+    }
+    for (i = 0; i < NTHREADS; i++) {
+        pthread_join(tid[i], &ret);
+        mu_assert(ret == NULL, "a binding is lost while other threads put.\n");
+    }
+
+    mu_assert(ctable_length(tbl) == NTHREADS * NKEYS / 2,
+              "ctable gets wrong length after concurrent updates.\n");
+    for (i = 0; i < NTHREADS * NKEYS; i++) {
+        void *v = ctable_get(tbl, &keys[i]);
+        mu_assert(v == ((i % 2) ? &keys[i] : NULL),
+                  "ctable gets wrong value after concurrent updates.\n");
+    }
+    return NULL;
+}
+
+void count(const void *key, void **value, void *cl)
+{
+    (void)key;
+    (void)value;
+    (*(int *)cl)++;
+}
+
+char *test_map()
+{
+    int n = 0;
+    ctable_map(tbl, count, &n);
+    mu_assert(n == ctable_length(tbl), "ctable_map misses bindings.\n");
+    return NULL;
+}
+
+char *test_free()
+{
+    ctable_free(&tbl, NULL);
+    mu_assert(tbl == NULL, "error when freeing table");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_put_get_remove);
+    mu_run_test(test_threads);
+    mu_run_test(test_map);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,156 @@
+#include "minunit.h"
+#include <fset.h>
+#include <set.h>
+#include <mem.h>
+
+#define N 20000
+
+static unsigned long seed = 88172645463325252UL;
+
+static unsigned long next_rand(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/* a set of about *n* keys drawn from [0, range) */
+static fset_t random_set(int n, unsigned long range, unsigned char *in)
+{
+    unsigned long *keys = zalloc((n + 1) * sizeof(*keys));
+    fset_t set;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        keys[i] = next_rand() % range;
+        in[keys[i]] = 1;
+    }
+    set = fset_new(keys, n);
+    zfree(keys);
+    return set;
+}
+
+/* does *set* hold exactly the keys marked in in[0..range), in order? */
+static int same(fset_t set, const unsigned char *in, unsigned long range)
+{
+    const unsigned long *keys = fset_keys(set);
+    unsigned long x;
+    int k = 0;
+
+    for (x = 0; x < range; x++) {
+        if (in[x]) {
+            if (k == fset_length(set) || keys[k++] != x) {
+                return 0;
+            }
+        }
+    }
+    return k == fset_length(set);
+}
+
+char *test_new_member()
+{
+    static unsigned long keys[] = {9, 3, 7, 3, 1, 9};
+    fset_t set = fset_new(keys, 6);
+    const unsigned long *sorted = fset_keys(set);
+
+    mu_assert(fset_length(set) == 4, "fset_new keeps duplicates.\n");
+    mu_assert(sorted[0] == 1 && sorted[1] == 3 && sorted[2] == 7
+              && sorted[3] == 9, "fset_new does not sort the keys.\n");
+    mu_assert(fset_member(set, 7) && !fset_member(set, 8)
+              && !fset_member(set, 10), "fset_member gets wrong.\n");
+    fset_free(&set);
+    mu_assert(set == NULL, "error when freeing set");
+    return NULL;
+}
+
+char *test_algebra()
+{
+    /* same sizes take the merge, far apart sizes the gallop */
+    static int sizes[][2] = {{N, N}, {N, 13}, {5, N}, {0, N}, {N, 100}};
+    static unsigned char in_s[4 * N], in_t[4 * N], expect[4 * N];
+    unsigned long range = 4 * N;
+    fset_t s, t, u;
+    unsigned long x;
+    int c;
+
+    for (c = 0; c < (int)(sizeof(sizes) / sizeof(sizes[0])); c++) {
+        memset(in_s, 0, sizeof(in_s));
+        memset(in_t, 0, sizeof(in_t));
+        s = random_set(sizes[c][0], range, in_s);
+        t = random_set(sizes[c][1], range, in_t);
+        mu_assert(same(s, in_s, range), "fset_new gets wrong keys.\n");
+
+        u = fset_inter(s, t);
+        for (x = 0; x < range; x++) {
+            expect[x] = in_s[x] & in_t[x];
+        }
+        mu_assert(same(u, expect, range), "fset_inter gets wrong.\n");
+        fset_free(&u);
+
+        u = fset_union(s, t);
+        for (x = 0; x < range; x++) {
+            expect[x] = in_s[x] | in_t[x];
+        }
+        mu_assert(same(u, expect, range), "fset_union gets wrong.\n");
+        fset_free(&u);
+
+        u = fset_minus(s, t);
+        for (x = 0; x < range; x++) {
+            expect[x] = in_s[x] & !in_t[x];
+        }
+        mu_assert(same(u, expect, range), "fset_minus gets wrong.\n");
+        fset_free(&u);
+
+        fset_free(&s);
+        fset_free(&t);
+    }
+    return NULL;
+}
+
+static unsigned long key_of(const void *member)
+{
+    return *(const int *)member;
+}
+
+char *test_freeze()
+{
+    static int nums[100];
+    set_t set = set_new(0, NULL, NULL);
+    fset_t by_member, by_key;
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        nums[i] = 100 - i;
+        set_put(set, &nums[i]);
+    }
+    by_member = set_freeze(set, NULL);
+    by_key = set_freeze(set, key_of);
+
+    mu_assert(fset_length(by_member) == 100 && fset_length(by_key) == 100,
+              "set_freeze gets wrong length.\n");
+    for (i = 0; i < 100; i++) {
+        mu_assert(fset_member(by_member, (unsigned long)&nums[i]),
+                  "set_freeze loses a member.\n");
+        mu_assert(fset_keys(by_key)[i] == (unsigned long)i + 1,
+                  "set_freeze gets wrong keys.\n");
+    }
+
+    fset_free(&by_member);
+    fset_free(&by_key);
+    set_free(&set, NULL);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new_member);
+    mu_run_test(test_algebra);
+    mu_run_test(test_freeze);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
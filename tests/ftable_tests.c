@@ -0,0 +1,129 @@
+#include "minunit.h"
+#include <ftable.h>
+#include <table.h>
+
+#define NKEYS 10000
+
+static int keys[NKEYS];
+static char *str_vals[] = {"0","1","2","3","4","5","6","7","8","9"};
+#define NELEM(x) (sizeof(x)/sizeof(x[0]))
+
+unsigned str_hash(const void *str)
+{
+    char *p = (char *)str;
+    unsigned hash_val = 0;
+    while (*p) {
+        hash_val = hash_val * 131 + *p;
+        p++;
+    }
+
+    return hash_val;
+}
+
+int str_cmp(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+/* every key collides */
+unsigned bad_hash(const void *str)
+{
+    (void)str;
+    return 42;
+}
+
+char *test_freeze()
+{
+    table_t tbl = table_new(NKEYS, NULL, NULL);
+    ftable_t ft;
+    int i;
+
+    for (i = 0; i < NKEYS; i += 2) {
+        table_put(tbl, &keys[i], &keys[i+1]);
+    }
+    ft = table_freeze(tbl);
+    table_free(&tbl, NULL);
+
+    mu_assert(ftable_length(ft) == NKEYS / 2, "ftable_length is wrong.\n");
+    for (i = 0; i < NKEYS; i += 2) {
+        mu_assert(ftable_get(ft, &keys[i]) == &keys[i+1],
+                  "ftable_get gets wrong value.\n");
+        mu_assert(ftable_get(ft, &keys[i+1]) == NULL,
+                  "ftable_get finds a key never inserted.\n");
+    }
+
+    ftable_free(&ft);
+    mu_assert(ft == NULL, "error when freeing ftable.\n");
+    return NULL;
+}
+
+void count(const void *key, void *value, void *cl)
+{
+    (void)key;
+    (void)value;
+    (*(int *)cl)++;
+}
+
+char *test_strings_and_collisions()
+{
+    table_t good = table_new(0, str_cmp, str_hash);
+    table_t bad = table_new(0, str_cmp, bad_hash);
+    ftable_t ft, fb;
+    unsigned i;
+    int n;
+
+    for (i = 0; i < NELEM(str_vals); i++) {
+        table_put(good, str_vals[i], &keys[i]);
+        table_put(bad, str_vals[i], &keys[i]);
+    }
+    ft = table_freeze(good);
+    fb = table_freeze(bad);
+
+    for (i = 0; i < NELEM(str_vals); i++) {
+        char key[2] = {'0' + i, '\0'};
+        mu_assert(ftable_get(ft, key) == &keys[i],
+                  "ftable_get gets wrong value.\n");
+        mu_assert(ftable_get(fb, key) == &keys[i],
+                  "ftable_get gets wrong value for colliding keys.\n");
+    }
+    mu_assert(ftable_get(ft, "10") == NULL, "ftable_get finds a wrong key.\n");
+    mu_assert(ftable_get(fb, "10") == NULL, "ftable_get finds a wrong key.\n");
+
+    n = 0;
+    ftable_map(ft, count, &n);
+    mu_assert(n == NELEM(str_vals), "ftable_map misses bindings.\n");
+    n = 0;
+    ftable_map(fb, count, &n);
+    mu_assert(n == NELEM(str_vals), "ftable_map misses bindings.\n");
+
+    ftable_free(&ft);
+    ftable_free(&fb);
+    table_free(&good, NULL);
+    table_free(&bad, NULL);
+    return NULL;
+}
+
+char *test_empty()
+{
+    table_t tbl = table_new(0, NULL, NULL);
+    ftable_t ft = table_freeze(tbl);
+
+    mu_assert(ftable_length(ft) == 0, "empty ftable has bindings.\n");
+    mu_assert(ftable_get(ft, &keys[0]) == NULL, "empty ftable finds a key.\n");
+    ftable_free(&ft);
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_freeze);
+    mu_run_test(test_strings_and_collisions);
+    mu_run_test(test_empty);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
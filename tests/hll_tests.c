@@ -0,0 +1,106 @@
+#include "minunit.h"
+#include <hll.h>
+#include <math.h>
+
+/* a hash of the integer *i*, any bijection will do */
+static unsigned hash_of(unsigned i)
+{
+    return i * 2654435761U;
+}
+
+/* is *count* within 4 standard errors of *n*? */
+static int close_to(hll_t hll, double count, double n)
+{
+    return fabs(count - n) <= 4 * hll_error(hll) * n;
+}
+
+char *test_new()
+{
+    hll_t hll = hll_new(0.01);
+
+    mu_assert(hll_precision(hll) == 14, "hll_new picks a wrong precision.\n");
+    mu_assert(hll_error(hll) <= 0.01, "hll_error is too large.\n");
+    mu_assert(hll_count(hll) == 0, "an empty sketch counts keys.\n");
+    hll_free(&hll);
+    mu_assert(hll == NULL, "hll_free is wrong.\n");
+
+    hll = hll_new(0.5);
+    mu_assert(hll_precision(hll) == 4, "hll_new goes below 4.\n");
+    hll_free(&hll);
+    hll = hll_new(0.0001);
+    mu_assert(hll_precision(hll) == 18, "hll_new goes above 18.\n");
+    hll_free(&hll);
+    return NULL;
+}
+
+char *test_count()
+{
+    static int sizes[] = {10, 1000, 30000, 1000000};
+    hll_t hll;
+    unsigned i;
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        hll = hll_new(0.01);
+        /* every key twice */
+        for (i = 0; i < 2 * (unsigned)sizes[k]; i++) {
+            hll_add(hll, hash_of(i % sizes[k]));
+        }
+        mu_assert(close_to(hll, hll_count(hll), sizes[k]),
+                  "hll_count is too far from the number of keys.\n");
+        hll_free(&hll);
+    }
+    return NULL;
+}
+
+char *test_merge()
+{
+    hll_t a = hll_new(0.02);
+    hll_t b = hll_new(0.02);
+    hll_t all = hll_new(0.02);
+    hll_t empty = hll_new(0.02);
+    double count;
+    unsigned i;
+
+    /* a = [0, 60000), b = [40000, 100000) */
+    for (i = 0; i < 100000; i++) {
+        if (i < 60000) {
+            hll_add(a, hash_of(i));
+        }
+        if (i >= 40000) {
+            hll_add(b, hash_of(i));
+        }
+        hll_add(all, hash_of(i));
+    }
+
+    hll_merge(a, b);
+    count = hll_count(a);
+    mu_assert(count == hll_count(all),
+              "hll_merge is not the sketch of the union.\n");
+    mu_assert(close_to(a, count, 100000),
+              "hll_count is too far after a merge.\n");
+    hll_merge(a, empty);
+    mu_assert(hll_count(a) == count, "merging an empty sketch changes it.\n");
+    hll_merge(empty, all);
+    mu_assert(hll_count(empty) == count,
+              "merging into an empty sketch is wrong.\n");
+
+    hll_free(&a);
+    hll_free(&b);
+    hll_free(&all);
+    hll_free(&empty);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_count);
+    mu_run_test(test_merge);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
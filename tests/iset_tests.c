@@ -0,0 +1,192 @@
+#include "minunit.h"
+#include <iset.h>
+#include <mem.h>
+#include <string.h>
+
+/* members are drawn from [0, N), spread over several chunks */
+#define N (1 << 19)
+
+static unsigned char in_s[N], in_t[N];
+
+iset_t s = NULL;
+
+static unsigned long seed = 88172645463325252UL;
+
+static unsigned long next_rand(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/* does *set* hold exactly the members marked in *in*? */
+static int same(iset_t set, const unsigned char *in)
+{
+    unsigned *array = iset_to_array(set);
+    unsigned long j = 0;
+    int i, ok = 1;
+
+    for (i = 0; i < N && ok; i++) {
+        if (in[i]) {
+            ok = j < iset_length(set) && array[j++] == (unsigned)i
+                 && iset_member(set, i);
+        } else {
+            ok = !iset_member(set, i);
+        }
+    }
+    ok = ok && j == iset_length(set);
+    zfree(array);
+    return ok;
+}
+
+char *test_new()
+{
+    s = iset_new();
+    mu_assert(s != NULL, "iset_new returned NULL.\n");
+    mu_assert(iset_length(s) == 0, "the length of new set is not 0.\n");
+    return NULL;
+}
+
+char *test_put_remove()
+{
+    int i;
+
+    iset_put(s, 7);
+    iset_put(s, 7);
+    iset_put(s, 0xffffffff);
+    mu_assert(iset_length(s) == 2, "iset_put gets wrong length.\n");
+    mu_assert(iset_member(s, 7) && iset_member(s, 0xffffffff),
+              "iset_member misses a member.\n");
+    mu_assert(!iset_member(s, 8), "iset_member finds a non member.\n");
+    mu_assert(iset_remove(s, 7), "iset_remove misses a member.\n");
+    mu_assert(!iset_remove(s, 7), "iset_remove removes a member twice.\n");
+    iset_remove(s, 0xffffffff);
+    mu_assert(iset_length(s) == 0, "iset_remove gets wrong length.\n");
+
+    /* dense and sparse chunks, with many removals */
+    for (i = 0; i < 4 * N; i++) {
+        unsigned long r = next_rand();
+        unsigned x = (r >> 8) % N;
+        /* the first chunk is dense, the others sparse */
+        if (x >= 65536 && (r & 0xf0) != 0) {
+            continue;
+        }
+        if (r & 3) {
+            iset_put(s, x);
+            in_s[x] = 1;
+        } else {
+            iset_remove(s, x);
+            in_s[x] = 0;
+        }
+    }
+    mu_assert(same(s, in_s), "iset gets wrong members.\n");
+    return NULL;
+}
+
+char *test_runs()
+{
+    iset_t t = iset_new();
+    long before;
+    int i;
+
+    /* runs of 1000 members */
+    for (i = 0; i < N; i++) {
+        in_t[i] = (i / 1000) % 2;
+        if (in_t[i]) {
+            iset_put(t, i);
+        }
+    }
+    before = iset_memory_usage(t);
+    iset_optimize(t);
+    mu_assert(iset_memory_usage(t) < before / 10,
+              "iset_optimize does not make runs.\n");
+    mu_assert(same(t, in_t), "iset_optimize loses members.\n");
+
+    /* split and join runs */
+    for (i = 0; i < N; i += 37) {
+        iset_remove(t, i);
+        in_t[i] = 0;
+        if (i + 100 < N) {
+            iset_put(t, i + 100);
+            in_t[i + 100] = 1;
+        }
+    }
+    mu_assert(same(t, in_t), "updating runs gets wrong members.\n");
+
+    iset_free(&t);
+    return NULL;
+}
+
+char *test_union_inter()
+{
+    static unsigned char expect[N];
+    iset_t t = iset_new(), u;
+    int i;
+
+    memset(in_t, 0, sizeof(in_t));
+    for (i = 0; i < N; i++) {
+        /* dense in the middle, runs at the end, sparse elsewhere */
+        int dense = i >= N / 4 && i < N / 2;
+        if ((dense && next_rand() % 3) || (!dense && next_rand() % 50 == 0)
+                || (i > N - 5000 && i % 1000 < 500)) {
+            in_t[i] = 1;
+            iset_put(t, i);
+        }
+    }
+    iset_optimize(t);
+
+    u = iset_union(s, t);
+    for (i = 0; i < N; i++) {
+        expect[i] = in_s[i] | in_t[i];
+    }
+    mu_assert(same(u, expect), "iset_union gets wrong members.\n");
+    iset_free(&u);
+
+    u = iset_inter(s, t);
+    for (i = 0; i < N; i++) {
+        expect[i] = in_s[i] & in_t[i];
+    }
+    mu_assert(same(u, expect), "iset_inter gets wrong members.\n");
+    iset_free(&u);
+
+    iset_free(&t);
+    return NULL;
+}
+
+char *test_memory()
+{
+    iset_t t = iset_new();
+    int i;
+
+    for (i = 0; i < N; i++) {
+        iset_put(t, i);
+    }
+    mu_assert(iset_memory_usage(t) * 8 <= (long)N * 2,
+              "a dense iset takes more than 2 bits per member.\n");
+    iset_free(&t);
+    return NULL;
+}
+
+char *test_free()
+{
+    iset_free(&s);
+    mu_assert(s == NULL, "error when freeing set");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_put_remove);
+    mu_run_test(test_runs);
+    mu_run_test(test_union_inter);
+    mu_run_test(test_memory);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
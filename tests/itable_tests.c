@@ -0,0 +1,108 @@
+#include "minunit.h"
+#include <itable.h>
+
+#define NKEYS 5000
+
+static int vals[NKEYS];
+
+itable_t tbl = NULL;
+
+char *test_new()
+{
+    tbl = itable_new(0);
+    mu_assert(tbl != NULL, "itable_new returned NULL.\n");
+    mu_assert(itable_length(tbl) == 0, "the length of new table is not 0.\n");
+    return NULL;
+}
+
+char *test_put_get_remove()
+{
+    void *tmp;
+
+    tmp = itable_put(tbl, 0, &vals[0]);
+    mu_assert(tmp == NULL, "itable_put returns value for a new key.\n");
+    tmp = itable_put(tbl, 0, &vals[1]);
+    mu_assert(tmp == &vals[0], "itable_put returns wrong prev value.\n");
+    itable_put(tbl, (unsigned long)&vals[2], &vals[2]);
+    mu_assert(itable_length(tbl) == 2, "itable_put gets wrong length.\n");
+
+    mu_assert(itable_get(tbl, 0) == &vals[1], "itable_get gets wrong value.\n");
+    mu_assert(itable_get(tbl, (unsigned long)&vals[2]) == &vals[2],
+              "itable_get gets wrong value for a pointer key.\n");
+    mu_assert(itable_get(tbl, 1) == NULL,
+              "itable_get finds a key never inserted.\n");
+
+    tmp = itable_remove(tbl, 0);
+    mu_assert(tmp == &vals[1], "itable_remove returns wrong value.\n");
+    mu_assert(itable_remove(tbl, 0) == NULL, "itable_remove removes twice.\n");
+    itable_remove(tbl, (unsigned long)&vals[2]);
+    mu_assert(itable_length(tbl) == 0, "itable_remove gets wrong length.\n");
+    return NULL;
+}
+
+/* random puts and removes, checked against a plain array */
+char *test_random()
+{
+    static void *ref[NKEYS];
+    unsigned long seed = 12345;
+    int i, n = 0;
+
+    for (i = 0; i < 20 * NKEYS; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        int k = (seed >> 33) % NKEYS;
+        if ((seed >> 20) & 3) {
+            n += ref[k] == NULL;
+            mu_assert(itable_put(tbl, k, &vals[k]) == ref[k],
+                      "itable_put returns wrong prev value.\n");
+            ref[k] = &vals[k];
+        } else {
+            n -= ref[k] != NULL;
+            mu_assert(itable_remove(tbl, k) == ref[k],
+                      "itable_remove returns wrong value.\n");
+            ref[k] = NULL;
+        }
+    }
+
+    mu_assert(itable_length(tbl) == n, "itable gets wrong length.\n");
+    for (i = 0; i < NKEYS; i++) {
+        mu_assert(itable_get(tbl, i) == ref[i], "itable gets wrong value.\n");
+    }
+    return NULL;
+}
+
+void count(unsigned long key, void **value, void *cl)
+{
+    (void)key;
+    (void)value;
+    (*(int *)cl)++;
+}
+
+char *test_map()
+{
+    int n = 0;
+    itable_map(tbl, count, &n);
+    mu_assert(n == itable_length(tbl), "itable_map misses bindings.\n");
+    return NULL;
+}
+
+char *test_free()
+{
+    itable_free(&tbl);
+    mu_assert(tbl == NULL, "error when freeing table");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_put_get_remove);
+    mu_run_test(test_random);
+    mu_run_test(test_map);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
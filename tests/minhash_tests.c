@@ -0,0 +1,101 @@
+#include "minunit.h"
+#include <minhash.h>
+#include <set.h>
+
+#define K 256
+
+static int nums[4000];
+
+/* the members &nums[lo, hi) */
+static set_t range_set(int lo, int hi)
+{
+    set_t set = set_new(hi - lo, NULL, NULL);
+    int i;
+
+    for (i = lo; i < hi; i++) {
+        set_put(set, &nums[i]);
+    }
+    return set;
+}
+
+static int same_slots(minhash_t s, minhash_t t)
+{
+    int i;
+
+    for (i = 0; i < minhash_length(s); i++) {
+        if (minhash_slots(s)[i] != minhash_slots(t)[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+char *test_jaccard()
+{
+    /* |a & b| = 1000, |a | b| = 2000, |a & c| = 0 */
+    set_t a = range_set(0, 1500);
+    set_t b = range_set(500, 2000);
+    set_t c = range_set(2000, 4000);
+    minhash_t sa = set_minhash(a, K, 1);
+    minhash_t sb = set_minhash(b, K, 1);
+    minhash_t sc = set_minhash(c, K, 1);
+    double j;
+
+    mu_assert(minhash_length(sa) == K, "minhash_length gets wrong.\n");
+    mu_assert(minhash_jaccard(sa, sa) == 1.0,
+              "a set is not similar to itself.\n");
+    j = minhash_jaccard(sa, sb);
+    mu_assert(j > 0.4 && j < 0.6, "minhash_jaccard is far from 0.5.\n");
+    j = minhash_jaccard(sa, sc);
+    mu_assert(j < 0.05, "minhash_jaccard is far from 0.\n");
+
+    minhash_free(&sa);
+    minhash_free(&sb);
+    minhash_free(&sc);
+    mu_assert(sa == NULL, "minhash_free is wrong.\n");
+    set_free(&a, NULL);
+    set_free(&b, NULL);
+    set_free(&c, NULL);
+    return NULL;
+}
+
+char *test_merge_parallel()
+{
+    set_t a = range_set(0, 1500);
+    set_t b = range_set(500, 3000);
+    set_t u = set_union(a, b);
+    minhash_t sa = set_minhash(a, K, 1);
+    minhash_t sb = set_minhash(b, K, 1);
+    minhash_t su = set_minhash(u, K, 4);
+    minhash_t empty = minhash_new(K);
+
+    /* a signature does not depend on the order of the keys */
+    minhash_merge(sa, sb);
+    mu_assert(same_slots(sa, su),
+              "minhash_merge is not the signature of the union.\n");
+    minhash_merge(sa, empty);
+    mu_assert(same_slots(sa, su), "merging an empty signature changes it.\n");
+    mu_assert(minhash_jaccard(empty, empty) == 1.0,
+              "empty signatures are not equal.\n");
+
+    minhash_free(&sa);
+    minhash_free(&sb);
+    minhash_free(&su);
+    minhash_free(&empty);
+    set_free(&a, NULL);
+    set_free(&b, NULL);
+    set_free(&u, NULL);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_jaccard);
+    mu_run_test(test_merge_parallel);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,167 @@
+#include "minunit.h"
+#include <mtable.h>
+#include <table.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+static char *str_vals[] = {"zero", "one", "two", "three", "four", "five",
+                           "six", "seven", "eight", "nine"};
+#define NELEM(x) (sizeof(x)/sizeof(x[0]))
+
+static char path[] = "/tmp/mtable_testsXXXXXX";
+
+unsigned str_hash(const void *str)
+{
+    char *p = (char *)str;
+    unsigned hash_val = 0;
+    while (*p) {
+        hash_val = hash_val * 131 + *p;
+        p++;
+    }
+
+    return hash_val;
+}
+
+int str_cmp(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+char *test_freeze()
+{
+    table_t tbl = table_new_inline(0, str_cmp, str_hash, sizeof(int));
+    struct stat st;
+    unsigned i;
+    int fd;
+
+    for (i = 0; i < NELEM(str_vals); i++) {
+        *(int *)table_slot(tbl, str_vals[i]) = i * 10;
+    }
+
+    fd = mkstemp(path);
+    mu_assert(fd >= 0, "cannot create a temporary file.\n");
+    close(fd);
+
+    umask(027);
+    mu_assert(table_freeze_to_file(tbl, path, sizeof(int)) == 0,
+              "table_freeze_to_file failed.\n");
+    mu_assert(stat(path, &st) == 0 && (st.st_mode & 0777) == 0640,
+              "table_freeze_to_file ignores the umask.\n");
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+char *test_open_get()
+{
+    mtable_t mt = mtable_open(path);
+    const int *v;
+    unsigned i;
+
+    mu_assert(mt != NULL, "mtable_open failed.\n");
+    mu_assert(mtable_length(mt) == NELEM(str_vals),
+              "mtable_length is wrong.\n");
+    mu_assert(mtable_value_size(mt) == sizeof(int),
+              "mtable_value_size is wrong.\n");
+
+    for (i = 0; i < NELEM(str_vals); i++) {
+        char key[16];
+        /* a copy, keys are compared by content */
+        strcpy(key, str_vals[i]);
+        v = mtable_get(mt, key);
+        mu_assert(v && *v == (int)i * 10, "mtable_get gets wrong value.\n");
+    }
+    mu_assert(mtable_get(mt, "ten") == NULL, "mtable_get finds a wrong key.\n");
+    mu_assert(mtable_get(mt, "") == NULL, "mtable_get finds a wrong key.\n");
+
+    mtable_close(&mt);
+    mu_assert(mt == NULL, "mtable_close did not reset the handle.\n");
+    return NULL;
+}
+
+/* does *path* open once its bytes at *offset* are replaced by *size* bytes
+ * of *patch*? The file is restored afterwards */
+static int opens_patched(long offset, const void *patch, size_t size)
+{
+    char saved[16];
+    mtable_t mt;
+    int ok;
+    FILE *fp = fopen(path, "r+b");
+
+    fseek(fp, offset, SEEK_SET);
+    fread(saved, size, 1, fp);
+    fseek(fp, offset, SEEK_SET);
+    fwrite(patch, size, 1, fp);
+    fflush(fp);
+
+    mt = mtable_open(path);
+    ok = mt != NULL;
+    if (mt) {
+        mtable_close(&mt);
+    }
+
+    fseek(fp, offset, SEEK_SET);
+    fwrite(saved, size, 1, fp);
+    fclose(fp);
+    return ok;
+}
+
+char *test_corrupt()
+{
+    /* the header takes 32 bytes and is followed by the buckets, then by
+     * the entries of 16 bytes, whose key_off is at byte 8 */
+    uint32_t nbuckets, bad_bucket = 1000;
+    uint64_t bad_off = 1 << 20;
+    long entries;
+    FILE *fp = fopen(path, "rb");
+
+    fseek(fp, 8, SEEK_SET);
+    fread(&nbuckets, sizeof(nbuckets), 1, fp);
+    fclose(fp);
+    entries = (32 + (nbuckets + 1) * 4 + 7) / 8 * 8;
+
+    mu_assert(opens_patched(0, "zzmtbl1", 8), "the file does not open.\n");
+    mu_assert(!opens_patched(32 + 4, &bad_bucket, sizeof(bad_bucket)),
+              "mtable_open accepts a bucket past the entries.\n");
+    mu_assert(!opens_patched(entries + 8, &bad_off, sizeof(bad_off)),
+              "mtable_open accepts a key past the keys.\n");
+    mu_assert(opens_patched(0, "zzmtbl1", 8), "the file is not restored.\n");
+    return NULL;
+}
+
+char *test_empty_and_invalid()
+{
+    table_t tbl = table_new(0, str_cmp, str_hash);
+    mtable_t mt;
+
+    mu_assert(table_freeze_to_file(tbl, path, sizeof(int)) == 0,
+              "table_freeze_to_file failed on an empty table.\n");
+    mt = mtable_open(path);
+    mu_assert(mt && mtable_length(mt) == 0, "empty mtable is wrong.\n");
+    mu_assert(mtable_get(mt, "zero") == NULL, "empty mtable finds a key.\n");
+    mtable_close(&mt);
+    table_free(&tbl, NULL);
+
+    FILE *fp = fopen(path, "w");
+    fputs("this is not a table, but it is long enough to have a header", fp);
+    fclose(fp);
+    mu_assert(mtable_open(path) == NULL, "mtable_open accepts garbage.\n");
+
+    unlink(path);
+    mu_assert(mtable_open(path) == NULL, "mtable_open opens a missing file.\n");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_freeze);
+    mu_run_test(test_open_get);
+    mu_run_test(test_corrupt);
+    mu_run_test(test_empty_and_invalid);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,147 @@
+#include "minunit.h"
+#include <ptable.h>
+
+#define N 100
+
+static int ids[N];
+static int files[3];
+
+ptable_t tbl = NULL;
+
+char *test_new()
+{
+    tbl = ptable_new(0);
+    mu_assert(tbl != NULL, "ptable_new returned NULL.\n");
+    mu_assert(ptable_length(tbl) == 0, "the length of new table is not 0.\n");
+    return NULL;
+}
+
+char *test_put_get_remove()
+{
+    int i, j;
+
+    /* id i is in files 0..i%3 */
+    for (i = 0; i < N; i++) {
+        for (j = 0; j <= i % 3; j++) {
+            mu_assert(ptable_put(tbl, &ids[i], &files[j], &ids[i]) == NULL,
+                      "ptable_put returns value for a new pair.\n");
+        }
+    }
+    mu_assert(ptable_length(tbl) == 34*1 + 33*2 + 33*3,
+              "ptable_put gets wrong length.\n");
+
+    mu_assert(ptable_put(tbl, &ids[2], &files[2], &files[2]) == &ids[2],
+              "ptable_put returns wrong prev value.\n");
+    mu_assert(ptable_get(tbl, &ids[2], &files[2]) == &files[2],
+              "ptable_get gets wrong value.\n");
+    mu_assert(ptable_get(tbl, &files[2], &ids[2]) == NULL,
+              "ptable_get mixes up the keys of a pair.\n");
+    mu_assert(ptable_get(tbl, &ids[0], &files[1]) == NULL,
+              "ptable_get finds a pair never inserted.\n");
+
+    mu_assert(ptable_remove(tbl, &ids[2], &files[2]) == &files[2],
+              "ptable_remove returns wrong value.\n");
+    mu_assert(ptable_remove(tbl, &ids[2], &files[2]) == NULL,
+              "ptable_remove removes a pair twice.\n");
+    mu_assert(ptable_get(tbl, &ids[2], &files[1]) == &ids[2],
+              "ptable_remove removes a wrong pair.\n");
+    return NULL;
+}
+
+void count(const void *k1, const void *k2, void **value, void *cl)
+{
+    (void)k1;
+    (void)k2;
+    (void)value;
+    (*(int *)cl)++;
+}
+
+char *test_map_prefix()
+{
+    int n = 0;
+
+    ptable_map_prefix(tbl, &ids[5], count, &n);
+    mu_assert(n == 3, "ptable_map_prefix misses bindings.\n");
+
+    n = 0;
+    ptable_map_prefix(tbl, &ids[2], count, &n);
+    mu_assert(n == 2, "ptable_map_prefix visits a removed binding.\n");
+
+    n = 0;
+    ptable_map_prefix(tbl, &files[0], count, &n);
+    mu_assert(n == 0, "ptable_map_prefix matches the second key.\n");
+
+    n = 0;
+    ptable_map(tbl, count, &n);
+    mu_assert(n == ptable_length(tbl), "ptable_map misses bindings.\n");
+    return NULL;
+}
+
+char *test_to_array()
+{
+    void **array = ptable_to_array(tbl, NULL);
+    int i;
+
+    for (i = 0; array[i]; i += 3) {
+        mu_assert(ptable_get(tbl, array[i], array[i+1]) == array[i+2],
+                  "ptable_to_array gets wrong triple.\n");
+    }
+    mu_assert(i == 3 * ptable_length(tbl), "ptable_to_array misses pairs.\n");
+    free(array);
+    return NULL;
+}
+
+char *test_long_prefix()
+{
+    static int k2s[10000];
+    ptable_t t = ptable_new(0);
+    int i, n = 0;
+
+    /* all pairs share their first key, every third one is removed from the
+     * middle of the prefix chain */
+    for (i = 0; i < 10000; i++) {
+        ptable_put(t, &files[0], &k2s[i], &k2s[i]);
+    }
+    for (i = 0; i < 10000; i += 3) {
+        mu_assert(ptable_remove(t, &files[0], &k2s[i]) == &k2s[i],
+                  "ptable_remove gets wrong in a long prefix.\n");
+    }
+    ptable_map_prefix(t, &files[0], count, &n);
+    mu_assert(n == 10000 - 3334 && n == ptable_length(t),
+              "ptable_map_prefix is wrong after removals.\n");
+
+    /* emptying the prefix, from both ends of its chain */
+    for (i = 0; i < 10000; i++) {
+        ptable_remove(t, &files[0], &k2s[(i & 1) ? i / 2 : 9999 - i / 2]);
+    }
+    n = 0;
+    ptable_map_prefix(t, &files[0], count, &n);
+    mu_assert(n == 0 && ptable_length(t) == 0,
+              "ptable_remove leaves pairs in a prefix.\n");
+
+    ptable_free(&t, NULL);
+    return NULL;
+}
+
+char *test_free()
+{
+    ptable_free(&tbl, NULL);
+    mu_assert(tbl == NULL, "error when freeing table");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_put_get_remove);
+    mu_run_test(test_map_prefix);
+    mu_run_test(test_to_array);
+    mu_run_test(test_long_prefix);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -280,6 +280,300 @@ char *test_diff()
     return NULL;
 }
 
+char *test_into()
+{
+    static int nums[1000];
+    static set_t (*ops[])(set_t, set_t) = {set_union, set_inter, set_minus,
+        set_diff};
+    static void (*intos[])(set_t, set_t) = {set_union_into, set_inter_into,
+        set_minus_into, set_diff_into};
+    set_t a = set_new(1000, NULL, NULL);
+    set_t b = set_new(1000, NULL, NULL);
+    set_t small = set_new(10, NULL, NULL);
+    int i, k;
+
+    /* a = [0, 600), b = [400, 1000), small = [590, 610) */
+    for (i = 0; i < 1000; i++) {
+        if (i < 600) {
+            set_put(a, &nums[i]);
+        }
+        if (i >= 400) {
+            set_put(b, &nums[i]);
+        }
+        if (i >= 590 && i < 610) {
+            set_put(small, &nums[i]);
+        }
+    }
+
+    for (k = 0; k < 4; k++) {
+        set_t expect = ops[k](a, b);
+        set_t dst = set_union(a, NULL);
+        intos[k](dst, b);
+        mu_assert(set_length(dst) == set_length(expect)
+                  && set_equal(dst, expect), "set_*_into gets wrong.\n");
+        set_free(&dst, NULL);
+        set_free(&expect, NULL);
+
+        /* a smaller src takes another path in set_minus_into */
+        expect = ops[k](a, small);
+        dst = set_union(a, NULL);
+        intos[k](dst, small);
+        mu_assert(set_length(dst) == set_length(expect)
+                  && set_equal(dst, expect), "set_*_into gets wrong.\n");
+        set_free(&dst, NULL);
+        set_free(&expect, NULL);
+    }
+    mu_assert(set_length(b) == 600, "set_*_into changes src.\n");
+
+    set_free(&a, NULL);
+    set_free(&b, NULL);
+    set_free(&small, NULL);
+    return NULL;
+}
+
+char *test_eq_subset_disjoint()
+{
+    static int nums[1000];
+    set_t a = set_new(1000, NULL, NULL);
+    set_t b = set_new(1000, NULL, NULL);
+    set_t c, d;
+    int i;
+
+    /* a = [0, 600), b = [400, 1000) */
+    for (i = 0; i < 1000; i++) {
+        if (i < 600) {
+            set_put(a, &nums[i]);
+        }
+        if (i >= 400) {
+            set_put(b, &nums[i]);
+        }
+    }
+
+    c = set_inter(a, b);
+    mu_assert(!set_eq(a, b) && set_eq(a, a), "set_eq gets wrong.\n");
+    mu_assert(set_subset(c, a) && set_subset(c, b) && !set_subset(a, c)
+              && !set_subset(a, b), "set_subset gets wrong.\n");
+    mu_assert(!set_disjoint(a, b) && !set_disjoint(c, a),
+              "set_disjoint gets wrong.\n");
+
+    /* sets built in different ways and orders are equal */
+    d = set_new(10, NULL, NULL);
+    for (i = 599; i >= 400; i--) {
+        set_put(d, &nums[i]);
+    }
+    mu_assert(set_eq(c, d) && set_eq(d, c), "set_eq gets wrong.\n");
+    set_put(d, &nums[0]);
+    set_remove(d, &nums[400]);
+    mu_assert(!set_eq(c, d) && !set_subset(d, c), "set_eq gets wrong.\n");
+    set_remove(d, &nums[0]);
+    set_put(d, &nums[400]);
+    mu_assert(set_eq(c, d), "set_eq gets wrong after removals.\n");
+    set_free(&d, NULL);
+
+    /* the in-place operations keep the fingerprint right */
+    d = set_union(a, NULL);
+    set_inter_into(d, b);
+    mu_assert(set_eq(c, d), "set_eq gets wrong after set_inter_into.\n");
+    set_free(&d, NULL);
+    d = set_minus(a, b);
+    mu_assert(set_disjoint(d, b) && set_disjoint(b, d) && set_subset(d, a),
+              "set_disjoint gets wrong.\n");
+    set_union_into(d, c);
+    mu_assert(set_eq(a, d), "set_eq gets wrong after set_union_into.\n");
+    set_free(&d, NULL);
+
+    d = set_new(0, NULL, NULL);
+    mu_assert(set_subset(d, a) && set_disjoint(d, a) && !set_eq(d, a),
+              "the empty set gets wrong.\n");
+
+    set_free(&a, NULL);
+    set_free(&b, NULL);
+    set_free(&c, NULL);
+    set_free(&d, NULL);
+    return NULL;
+}
+
+char *test_member_batch()
+{
+    static int nums[1000];
+    const void *probes[1000];
+    set_t set = set_new(0, NULL, NULL);
+    bit_t out = bit_new(1000);
+    int i, k;
+
+    /* every third number is a member, probes cover several batches */
+    for (i = 0; i < 1000; i += 3) {
+        set_put(set, &nums[i]);
+    }
+    for (i = 0; i < 1000; i++) {
+        probes[i] = &nums[(i * 7) % 1000];
+    }
+
+    /* the second round goes through a bloom filter */
+    for (k = 0; k < 2; k++) {
+        set_member_batch(set, probes, 1000, out);
+        for (i = 0; i < 1000; i++) {
+            mu_assert(bit_get(out, i) == set_member(set, probes[i]),
+                      "set_member_batch disagrees with set_member.\n");
+        }
+        mu_assert(bit_count(out) == set_length(set),
+                  "set_member_batch finds a wrong number of members.\n");
+        set_bloom(set, set_length(set));
+    }
+    set_member_batch(set, probes, 0, out);
+
+    bit_free(&out);
+    set_free(&set, NULL);
+    return NULL;
+}
+
+void count_member(const void *member, void *wcl)
+{
+    (void)member;
+    (*(int *)wcl)++;
+}
+
+void add_int(void *wcl, void *cl)
+{
+    *(int *)cl += *(int *)wcl;
+}
+
+char *test_map_parallel()
+{
+    static int nums[1000];
+    set_t s = set_new(1000, NULL, NULL);
+    int counts[3] = {0, 0, 0};
+    void *wcl[3] = {&counts[0], &counts[1], &counts[2]};
+    int total = 0;
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        set_put(s, &nums[i]);
+    }
+    set_map_parallel(s, 3, count_member, wcl, add_int, &total);
+    mu_assert(total == 1000, "set_map_parallel misses members.\n");
+    mu_assert(counts[0] > 0 && counts[2] > 0,
+              "set_map_parallel does not split the work.\n");
+
+    set_free(&s, NULL);
+    return NULL;
+}
+
+char *test_shrink_to_fit()
+{
+    static int nums[100000];
+    set_t s = set_new(100000, NULL, NULL);
+    long full, shrunk;
+    int i;
+
+    for (i = 0; i < 100000; i++) {
+        set_put(s, &nums[i]);
+    }
+    full = set_memory_usage(s);
+    for (i = 10; i < 100000; i++) {
+        set_remove(s, &nums[i]);
+    }
+    mu_assert(set_memory_usage(s) < full, "set_memory_usage ignores nodes.\n");
+    set_shrink_to_fit(s);
+    shrunk = set_memory_usage(s);
+    mu_assert(shrunk < 8192, "set_shrink_to_fit keeps buckets.\n");
+    for (i = 0; i < 10; i++) {
+        mu_assert(set_member(s, &nums[i]), "set_shrink_to_fit loses a member.\n");
+    }
+
+    set_free(&s, NULL);
+    return NULL;
+}
+
+char *test_resize()
+{
+    static int nums[200000];
+    set_t s = set_new(0, NULL, NULL);
+    long grown;
+    int i;
+
+    for (i = 0; i < 200000; i++) {
+        set_put(s, &nums[i]);
+    }
+    /* more buckets than the 65521 a set used to stop at */
+    grown = set_memory_usage(s) - 200000 * 2 * sizeof(void *);
+    mu_assert(grown > 65521 * (long)sizeof(void *), "a set does not grow.\n");
+    for (i = 0; i < 200000; i++) {
+        mu_assert(set_member(s, &nums[i]), "a growing set loses a member.\n");
+    }
+
+    for (i = 10; i < 200000; i++) {
+        set_remove(s, &nums[i]);
+    }
+    mu_assert(set_memory_usage(s) < 8192, "a set does not shrink.\n");
+    for (i = 0; i < 10; i++) {
+        mu_assert(set_member(s, &nums[i]), "a shrinking set loses a member.\n");
+    }
+    mu_assert(set_length(s) == 10, "a resized set gets wrong length.\n");
+
+    set_free(&s, NULL);
+    return NULL;
+}
+
+char *test_small()
+{
+    static int nums[20];
+    set_t s = set_new(0, NULL, NULL);
+    long small;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        set_put(s, &nums[i]);
+    }
+    small = set_memory_usage(s);
+    mu_assert(small < 512, "a small set allocates buckets.\n");
+    for (i = 8; i < 20; i++) {
+        set_put(s, &nums[i]);
+    }
+    mu_assert(set_memory_usage(s) > small + 12 * 2 * (long)sizeof(void *),
+              "a small set does not grow.\n");
+    for (i = 0; i < 20; i++) {
+        mu_assert(set_member(s, &nums[i]), "a small set loses a member.\n");
+    }
+
+    for (i = 3; i < 20; i++) {
+        set_remove(s, &nums[i]);
+    }
+    set_shrink_to_fit(s);
+    mu_assert(set_memory_usage(s) < small, "a set does not become small.\n");
+    for (i = 0; i < 20; i++) {
+        mu_assert(set_member(s, &nums[i]) == (i < 3),
+                  "a set gets wrong members once small.\n");
+    }
+
+    set_free(&s, NULL);
+    return NULL;
+}
+
+char *test_bloom()
+{
+    static int nums[2000];
+    set_t s = set_new(0, NULL, NULL);
+    bloom_t bloom = set_bloom(s, 1000);
+    long rejected, fps;
+    int i;
+
+    bloom_count(bloom, true);
+    for (i = 0; i < 1000; i++) {
+        set_put(s, &nums[i]);
+    }
+    for (i = 0; i < 2000; i++) {
+        mu_assert(set_member(s, &nums[i]) == (i < 1000),
+                  "set_member gets wrong behind a Bloom filter.\n");
+    }
+    bloom_stats(bloom, NULL, &rejected, &fps);
+    mu_assert(rejected + fps == 1000 && rejected > 900,
+              "the Bloom filter of a set does not reject misses.\n");
+
+    set_free(&s, NULL);
+    return NULL;
+}
+
 char *test_free()
 {
     set_free(&set_int, NULL);
@@ -295,12 +589,20 @@ char *all_tests()
 
     mu_run_test(test_new);
     mu_run_test(test_member_put_remove);
+    mu_run_test(test_member_batch);
     mu_run_test(test_map);
     mu_run_test(test_to_array);
     mu_run_test(test_union);
     mu_run_test(test_inter);
     mu_run_test(test_minus);
     mu_run_test(test_diff);
+    mu_run_test(test_into);
+    mu_run_test(test_eq_subset_disjoint);
+    mu_run_test(test_map_parallel);
+    mu_run_test(test_shrink_to_fit);
+    mu_run_test(test_resize);
+    mu_run_test(test_small);
+    mu_run_test(test_bloom);
     mu_run_test(test_free);
 
     return NULL;
@@ -1,5 +1,6 @@
 #include "minunit.h"
 #include <table.h>
+#include <mem.h>
 
 static int keys[]={0,1,2,3,4,5,6,7,8,9};
 static char *str_vals[]={"0","1","2","3","4","5","6","7","8","9"};
@@ -142,6 +143,413 @@ char *test_to_array()
     return NULL;
 }
 
+char *test_inline()
+{
+    table_t tbl = table_new_inline(0, str_cmp, str_hash, sizeof(int));
+    int *count;
+
+    count = table_get(tbl, str_vals[0]);
+    mu_assert(count == NULL, "table_get finds a key never inserted.\n");
+
+    count = table_slot(tbl, str_vals[0]);
+    mu_assert(count != NULL && *count == 0, "table_slot is not zeroed.\n");
+    (*count) += 3;
+    count = table_slot(tbl, str_vals[1]);
+    (*count) ++;
+    mu_assert(table_length(tbl) == 2, "table_slot gets wrong length.\n");
+
+    count = table_slot(tbl, str_vals[0]);
+    mu_assert(*count == 3, "table_slot does not return the same slot.\n");
+    count = table_get(tbl, str_vals[1]);
+    mu_assert(count && *count == 1, "table_get gets wrong slot.\n");
+
+    void **array = table_to_array(tbl, NULL);
+    mu_assert(*(int *)array[1] + *(int *)array[3] == 4,
+              "table_to_array gets wrong values.\n");
+    zfree(array);
+
+    mu_assert(table_remove(tbl, str_vals[0]) == NULL,
+              "table_remove returns storage of an inline table.\n");
+    mu_assert(table_get(tbl, str_vals[0]) == NULL,
+              "value is not correctly removed from table.\n");
+    mu_assert(table_length(tbl) == 1, "table_remove gets wrong length.\n");
+
+    table_free(&tbl, NULL);
+    mu_assert(tbl == NULL, "error when freeing table");
+    return NULL;
+}
+
+char *test_batch()
+{
+    table_t tbl = table_new(0, NULL, NULL);
+    const void *bkeys[NELEM(keys) + 1];
+    void *values[NELEM(keys) + 1];
+    void *prevs[NELEM(keys) + 1];
+    unsigned i;
+
+    /* the last key repeats the first one */
+    for (i = 0; i < NELEM(keys); i++) {
+        bkeys[i] = &keys[i];
+        values[i] = str_vals[i];
+    }
+    bkeys[i] = &keys[0];
+    values[i] = str_vals[1];
+
+    table_put_batch(tbl, bkeys, values, NELEM(keys) + 1, prevs);
+    mu_assert(table_length(tbl) == NELEM(keys),
+              "table_put_batch gets wrong length.\n");
+    mu_assert(prevs[0] == NULL && prevs[NELEM(keys)] == str_vals[0],
+              "table_put_batch returns wrong prev values.\n");
+
+    table_remove(tbl, &keys[3]);
+    table_get_batch(tbl, bkeys, NELEM(keys), values);
+    mu_assert(values[0] == str_vals[1], "table_get_batch gets wrong value.\n");
+    mu_assert(values[3] == NULL, "table_get_batch finds a removed key.\n");
+    for (i = 1; i < NELEM(keys); i++) {
+        if (i != 3) {
+            mu_assert(values[i] == str_vals[i],
+                      "table_get_batch gets wrong value.\n");
+        }
+    }
+
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+void sum_values(const void *key, void **value, void *wcl)
+{
+    (void)key;
+    *(long *)wcl += *(int *)*value;
+    /* values may be changed, point every key at the next value */
+    *value = (int *)*value + 1;
+}
+
+void add_long(void *wcl, void *cl)
+{
+    *(long *)cl += *(long *)wcl;
+}
+
+char *test_map_parallel()
+{
+    static int nums[1001];
+    table_t tbl = table_new(1000, NULL, NULL);
+    long sums[4] = {0, 0, 0, 0};
+    void *wcl[4] = {&sums[0], &sums[1], &sums[2], &sums[3]};
+    long total = 0;
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+        table_put(tbl, &nums[i], &nums[i]);
+    }
+    nums[1000] = 1000;
+
+    table_map_parallel(tbl, 4, sum_values, wcl, add_long, &total);
+    mu_assert(total == 999 * 1000 / 2, "table_map_parallel gets wrong sum.\n");
+    mu_assert(sums[0] > 0 && sums[3] > 0,
+              "table_map_parallel does not split the work.\n");
+    for (i = 0; i < 1000; i++) {
+        mu_assert(table_get(tbl, &nums[i]) == &nums[i+1],
+                  "table_map_parallel did not change the values.\n");
+    }
+
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+void *add_counts(const void *key, void *dst_value, void *src_value, void *cl)
+{
+    (void)key;
+    (void)cl;
+    *(int *)dst_value += *(int *)src_value;
+    return dst_value;
+}
+
+char *test_merge()
+{
+    table_t a = table_new_inline(0, str_cmp, str_hash, sizeof(int));
+    table_t b = table_new_inline(0, str_cmp, str_hash, sizeof(int));
+    int *count;
+
+    /* a = {0:1, 1:1}, b = {1:2, 2:2} */
+    (*(int *)table_slot(a, str_vals[0])) += 1;
+    (*(int *)table_slot(a, str_vals[1])) += 1;
+    (*(int *)table_slot(b, str_vals[1])) += 2;
+    count = table_slot(b, str_vals[2]);
+    (*count) += 2;
+
+    table_merge(a, b, add_counts, NULL);
+    mu_assert(table_length(b) == 0, "table_merge did not empty src.\n");
+    mu_assert(table_length(a) == 3, "table_merge gets wrong length.\n");
+    mu_assert(*(int *)table_get(a, str_vals[0]) == 1,
+              "table_merge changes a value only in dst.\n");
+    mu_assert(*(int *)table_get(a, str_vals[1]) == 3,
+              "table_merge did not reduce a common key.\n");
+    mu_assert(table_get(a, str_vals[2]) == count,
+              "table_merge reallocated a binding.\n");
+    mu_assert(*count == 2, "table_merge changes a value only in src.\n");
+
+    table_free(&a, NULL);
+    table_free(&b, NULL);
+    return NULL;
+}
+
+char *test_merge_tree()
+{
+    table_t tables[5];
+    int i, j;
+
+    /* table i counts the keys [i, 10) once */
+    for (i = 0; i < 5; i++) {
+        tables[i] = table_new_inline(0, NULL, NULL, sizeof(int));
+        for (j = i; j < 10; j++) {
+            (*(int *)table_slot(tables[i], &keys[j])) ++;
+        }
+    }
+
+    table_merge_tree(tables, 5, add_counts, NULL);
+    mu_assert(table_length(tables[0]) == 10,
+              "table_merge_tree gets wrong length.\n");
+    for (j = 0; j < 10; j++) {
+        int expect = (j < 5) ? j + 1 : 5;
+        mu_assert(*(int *)table_get(tables[0], &keys[j]) == expect,
+                  "table_merge_tree gets wrong value.\n");
+    }
+    for (i = 0; i < 5; i++) {
+        mu_assert(i == 0 || table_length(tables[i]) == 0,
+                  "table_merge_tree did not empty a table.\n");
+        table_free(&tables[i], NULL);
+    }
+    return NULL;
+}
+
+char *test_shrink_to_fit()
+{
+    static int nums[100000];
+    table_t tbl = table_new(100000, NULL, NULL);
+    long full, emptied, shrunk;
+    int i;
+
+    for (i = 0; i < 100000; i++) {
+        table_put(tbl, &nums[i], &nums[i]);
+    }
+    full = table_memory_usage(tbl);
+    for (i = 10; i < 100000; i++) {
+        table_remove(tbl, &nums[i]);
+    }
+    emptied = table_memory_usage(tbl);
+    table_shrink_to_fit(tbl);
+    shrunk = table_memory_usage(tbl);
+
+    mu_assert(emptied < full, "table_memory_usage ignores bindings.\n");
+    mu_assert(shrunk < emptied / 10, "table_shrink_to_fit keeps buckets.\n");
+    for (i = 0; i < 10; i++) {
+        mu_assert(table_get(tbl, &nums[i]) == &nums[i],
+                  "table_shrink_to_fit loses a binding.\n");
+    }
+    mu_assert(table_length(tbl) == 10, "table_shrink_to_fit gets wrong length.\n");
+
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+char *test_recycle()
+{
+    static int nums[100];
+    table_t tbl = table_new_inline(100, NULL, NULL, sizeof(int));
+    long empty, recycled;
+    int i;
+
+    empty = table_memory_usage(tbl);
+    table_recycle(tbl, 50);
+    for (i = 0; i < 100; i++) {
+        *(int *)table_slot(tbl, &nums[i]) = i;
+    }
+    for (i = 0; i < 100; i++) {
+        table_remove(tbl, &nums[i]);
+    }
+    recycled = table_memory_usage(tbl);
+    mu_assert(recycled > empty, "table_recycle keeps no binding.\n");
+
+    /* reused bindings come back zeroed */
+    for (i = 0; i < 100; i++) {
+        mu_assert(*(int *)table_slot(tbl, &nums[i]) == 0,
+                  "a recycled binding keeps its old value.\n");
+    }
+    mu_assert(table_length(tbl) == 100, "table_recycle gets wrong length.\n");
+
+    for (i = 0; i < 100; i++) {
+        table_remove(tbl, &nums[i]);
+    }
+    mu_assert(table_memory_usage(tbl) == recycled,
+              "table_recycle keeps more than its cap.\n");
+    table_recycle(tbl, 0);
+    mu_assert(table_memory_usage(tbl) == empty,
+              "table_recycle does not free the spare bindings.\n");
+
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+char *test_small()
+{
+    static int nums[40];
+    const void *keys[20];
+    void *values[20];
+    table_t tbl = table_new(0, NULL, NULL);
+    table_t src = table_new(0, NULL, NULL);
+    long small;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        table_put(tbl, &nums[i], &nums[i]);
+    }
+    small = table_memory_usage(tbl);
+    mu_assert(small < 512, "a small table allocates buckets.\n");
+
+    /* a batch and a merge that both take a small table past its limit */
+    for (i = 0; i < 20; i++) {
+        keys[i] = &nums[i];
+        values[i] = &nums[i];
+        table_put(src, &nums[20 + i], &nums[20 + i]);
+    }
+    table_put_batch(tbl, keys, values, 20, NULL);
+    table_merge(tbl, src, NULL, NULL);
+    mu_assert(table_memory_usage(tbl) > small + 32 * 3 * (long)sizeof(void *),
+              "a small table does not grow.\n");
+    for (i = 0; i < 40; i++) {
+        mu_assert(table_get(tbl, &nums[i]) == &nums[i],
+                  "a small table loses a binding.\n");
+    }
+
+    for (i = 3; i < 40; i++) {
+        table_remove(tbl, &nums[i]);
+    }
+    table_shrink_to_fit(tbl);
+    mu_assert(table_memory_usage(tbl) < small,
+              "a table does not become small.\n");
+    for (i = 0; i < 40; i++) {
+        mu_assert(table_get(tbl, &nums[i]) == ((i < 3) ? &nums[i] : NULL),
+                  "a table gets wrong bindings once small.\n");
+    }
+
+    table_free(&src, NULL);
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+char *test_bloom()
+{
+    static int nums[2000];
+    static const void *probes[2000];
+    static void *values[2000];
+    table_t tbl = table_new(0, NULL, NULL);
+    bloom_t bloom;
+    long queries, rejected, fps;
+    int i;
+
+    for (i = 0; i < 500; i++) {
+        table_put(tbl, &nums[i], &nums[i]);
+    }
+    bloom = table_bloom(tbl, 1000);
+    bloom_count(bloom, true);
+    for (i = 500; i < 1000; i++) {
+        table_put(tbl, &nums[i], &nums[i]);
+    }
+    for (i = 0; i < 2000; i++) {
+        mu_assert(table_get(tbl, &nums[i]) == ((i < 1000) ? &nums[i] : NULL),
+                  "table_get gets wrong behind a Bloom filter.\n");
+    }
+    bloom_stats(bloom, &queries, &rejected, &fps);
+    mu_assert(queries == 2000 && rejected + fps == 1000 && rejected > 900,
+              "the Bloom filter of a table does not reject misses.\n");
+
+    /* table_get_batch goes through the filter too */
+    for (i = 0; i < 2000; i++) {
+        probes[i] = &nums[i];
+    }
+    table_get_batch(tbl, probes, 2000, values);
+    for (i = 0; i < 2000; i++) {
+        mu_assert(values[i] == ((i < 1000) ? &nums[i] : NULL),
+                  "table_get_batch gets wrong behind a Bloom filter.\n");
+    }
+    bloom_stats(bloom, &queries, &rejected, &fps);
+    mu_assert(queries == 4000 && rejected + fps == 2000,
+              "table_get_batch does not consult the Bloom filter.\n");
+    mu_assert(table_bloom(tbl, 0) == NULL, "table_bloom does not detach.\n");
+
+    table_free(&tbl, NULL);
+    return NULL;
+}
+
+static int nkeys_made;
+
+/* counts the keys created, the key is the first *len* bytes of a copy */
+const char *make_key(const char *str, int len)
+{
+    char *key = zalloc(len + 1);
+    memcpy(key, str, len);
+    key[len] = '\0';
+    nkeys_made ++;
+    return key;
+}
+
+void free_key(const void *key, void *value)
+{
+    (void)value;
+    zfree((void *)key);
+}
+
+char *test_bytes()
+{
+    table_t tbl = table_new(0, table_cmp_string, table_hash_string);
+    table_t cnt = table_new_inline(0, table_cmp_string, table_hash_string,
+                                   sizeof(int));
+    const char *text = "onetwoone";
+    int *count;
+    bloom_t bloom;
+    long queries;
+
+    nkeys_made = 0;
+    mu_assert(table_get_bytes(tbl, text, 3) == NULL,
+              "table_get_bytes finds a key never inserted.\n");
+    mu_assert(table_put_bytes(tbl, text, 3, &keys[1], make_key) == NULL,
+              "table_put_bytes returns value for a new key.\n");
+    mu_assert(table_put_bytes(tbl, text + 6, 3, &keys[2], make_key) == &keys[1],
+              "table_put_bytes returns wrong prev value.\n");
+    mu_assert(nkeys_made == 1, "table_put_bytes makes a key twice.\n");
+    mu_assert(table_get(tbl, "one") == &keys[2],
+              "table_get does not find a key put as bytes.\n");
+    mu_assert(table_get_bytes(tbl, text, 2) == NULL,
+              "table_get_bytes matches a prefix of a key.\n");
+    mu_assert(table_get_bytes(tbl, "onetw", 5) == NULL,
+              "table_get_bytes matches a longer slice.\n");
+
+    count = table_slot_bytes(cnt, text + 3, 3, make_key);
+    (*count) ++;
+    count = table_slot_bytes(cnt, "two", 3, make_key);
+    (*count) ++;
+    mu_assert(nkeys_made == 2, "table_slot_bytes makes a key twice.\n");
+    count = table_get_bytes(cnt, text + 3, 3);
+    mu_assert(count && *count == 2, "table_slot_bytes gets wrong slot.\n");
+
+    /* the bytes functions go through a Bloom filter */
+    bloom = table_bloom(tbl, 100);
+    bloom_count(bloom, true);
+    mu_assert(table_get_bytes(tbl, text + 3, 3) == NULL
+              && table_get_bytes(tbl, text, 3) == &keys[2],
+              "table_get_bytes gets wrong behind a Bloom filter.\n");
+    mu_assert(table_put_bytes(tbl, text + 3, 3, &keys[3], make_key) == NULL
+              && table_get(tbl, "two") == &keys[3],
+              "table_put_bytes gets wrong behind a Bloom filter.\n");
+    bloom_stats(bloom, &queries, NULL, NULL);
+    mu_assert(queries == 4, "the bytes functions skip the filter.\n");
+
+    table_free(&tbl, free_key);
+    table_free(&cnt, free_key);
+    return NULL;
+}
+
 char *test_free()
 {
     table_free(&num_tbl, NULL);
@@ -158,6 +566,16 @@ char *all_tests()
     mu_run_test(test_new);
     mu_run_test(test_put_get_remove);
     mu_run_test(test_to_array);
+    mu_run_test(test_inline);
+    mu_run_test(test_batch);
+    mu_run_test(test_map_parallel);
+    mu_run_test(test_merge);
+    mu_run_test(test_merge_tree);
+    mu_run_test(test_shrink_to_fit);
+    mu_run_test(test_recycle);
+    mu_run_test(test_small);
+    mu_run_test(test_bloom);
+    mu_run_test(test_bytes);
     mu_run_test(test_free);
 
     return NULL;
@@ -0,0 +1,190 @@
+#include "minunit.h"
+#include <vtable.h>
+#include <pthread.h>
+
+#define NKEYS 10000
+
+static int keys[NKEYS];
+
+vtable_t tbl = NULL;
+
+char *test_new()
+{
+    tbl = vtable_new(0, NULL, NULL);
+    mu_assert(tbl != NULL, "vtable_new returned NULL.\n");
+    mu_assert(vtable_length(tbl) == 0, "the length of new table is not 0.\n");
+    return NULL;
+}
+
+char *test_put_get_remove()
+{
+    void *tmp;
+
+    tmp = vtable_put(tbl, &keys[0], &keys[0]);
+    mu_assert(tmp == NULL, "vtable_put returns value for a new key.\n");
+    tmp = vtable_put(tbl, &keys[0], &keys[1]);
+    mu_assert(tmp == &keys[0], "vtable_put returns wrong prev value.\n");
+    vtable_put(tbl, &keys[1], &keys[1]);
+    mu_assert(vtable_length(tbl) == 2, "vtable_put gets wrong length.\n");
+
+    tmp = vtable_get(tbl, &keys[0]);
+    mu_assert(tmp == &keys[1], "vtable_get gets wrong value.\n");
+    tmp = vtable_get(tbl, &keys[2]);
+    mu_assert(tmp == NULL, "vtable_get finds a key never inserted.\n");
+
+    tmp = vtable_remove(tbl, &keys[0]);
+    mu_assert(tmp == &keys[1], "vtable_remove returns wrong value.\n");
+    tmp = vtable_remove(tbl, &keys[0]);
+    mu_assert(tmp == NULL, "vtable_remove removes a key twice.\n");
+    mu_assert(vtable_length(tbl) == 1, "vtable_remove gets wrong length.\n");
+
+    vtable_remove(tbl, &keys[1]);
+    return NULL;
+}
+
+char *test_snapshot()
+{
+    vtable_t snap, snap2;
+    int i;
+
+    for (i = 0; i < NKEYS; i += 2) {
+        vtable_put(tbl, &keys[i], &keys[i]);
+    }
+    snap = vtable_snapshot(tbl);
+    mu_assert(vtable_length(snap) == NKEYS / 2, "snapshot gets wrong length.\n");
+
+    /* change every key the snapshot knows, and add the others */
+    for (i = 0; i < NKEYS; i++) {
+        if (i % 4 == 0) {
+            vtable_remove(tbl, &keys[i]);
+        } else {
+            vtable_put(tbl, &keys[i], &keys[NKEYS - 1 - i]);
+        }
+    }
+    snap2 = vtable_snapshot(tbl);
+
+    for (i = 0; i < NKEYS; i++) {
+        mu_assert(vtable_get(snap, &keys[i]) == ((i % 2) ? NULL : &keys[i]),
+                  "a snapshot sees a later update.\n");
+        mu_assert(vtable_get(snap2, &keys[i])
+                  == ((i % 4) ? &keys[NKEYS - 1 - i] : NULL),
+                  "a second snapshot gets wrong value.\n");
+    }
+    mu_assert(vtable_length(snap) == NKEYS / 2, "snapshot length changes.\n");
+    mu_assert(vtable_length(tbl) == NKEYS - NKEYS / 4,
+              "vtable gets wrong length after a snapshot.\n");
+
+    vtable_free(&snap);
+    vtable_free(&snap2);
+    mu_assert(vtable_get(tbl, &keys[1]) == &keys[NKEYS - 2],
+              "freeing a snapshot changes the table.\n");
+    return NULL;
+}
+
+static void sum(const void *key, void *value, void *cl)
+{
+    (void)value;
+    *(long *)cl += (const int *)key - keys;
+}
+
+/* iterate a snapshot while the main thread keeps writing */
+static void *reader(void *arg)
+{
+    static long total;
+    vtable_t snap = arg;
+    int round;
+
+    for (round = 0; round < 20; round++) {
+        total = 0;
+        vtable_map(snap, sum, &total);
+    }
+    vtable_free(&snap);
+    return &total;
+}
+
+char *test_threads()
+{
+    pthread_t tid;
+    vtable_t snap;
+    long expect = 0, *total;
+    int i, round;
+
+    for (i = 0; i < NKEYS; i++) {
+        vtable_put(tbl, &keys[i], &keys[i]);
+        expect += i;
+    }
+    snap = vtable_snapshot(tbl);
+    pthread_create(&tid, NULL, reader, snap);
+    for (round = 0; round < 10; round++) {
+        for (i = round; i < NKEYS; i += 10) {
+            vtable_remove(tbl, &keys[i]);
+        }
+        for (i = round; i < NKEYS; i += 10) {
+            vtable_put(tbl, &keys[i], &keys[i]);
+        }
+    }
+    pthread_join(tid, (void **)&total);
+
+    mu_assert(*total == expect,
+              "a snapshot changes while the table is written.\n");
+    mu_assert(vtable_length(tbl) == NKEYS, "vtable gets wrong length.\n");
+    return NULL;
+}
+
+/* go far past the hint while a snapshot holds the first directory */
+char *test_grow()
+{
+    static int many[64 * NKEYS];
+    vtable_t big, snap;
+    int i, n = 64 * NKEYS;
+
+    big = vtable_new(64, NULL, NULL);
+    for (i = 0; i < NKEYS; i++) {
+        vtable_put(big, &many[i], &many[i]);
+    }
+    snap = vtable_snapshot(big);
+    for (i = 0; i < n; i++) {
+        vtable_put(big, &many[i], &many[n - 1 - i]);
+    }
+    mu_assert(vtable_length(big) == n,
+              "vtable gets wrong length after growing.\n");
+    mu_assert(vtable_length(snap) == NKEYS,
+              "snapshot length changes when growing.\n");
+    for (i = 0; i < n; i++) {
+        mu_assert(vtable_get(big, &many[i]) == &many[n - 1 - i],
+                  "vtable loses a binding when growing.\n");
+        mu_assert(vtable_get(snap, &many[i]) == (i < NKEYS ? &many[i] : NULL),
+                  "a snapshot sees the table grow.\n");
+    }
+    vtable_free(&snap);
+    for (i = 0; i < n; i += 2) {
+        vtable_remove(big, &many[i]);
+    }
+    mu_assert(vtable_length(big) == n / 2,
+              "vtable_remove gets wrong length after growing.\n");
+    vtable_free(&big);
+    return NULL;
+}
+
+char *test_free()
+{
+    vtable_free(&tbl);
+    mu_assert(tbl == NULL, "error when freeing table");
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_new);
+    mu_run_test(test_put_get_remove);
+    mu_run_test(test_snapshot);
+    mu_run_test(test_threads);
+    mu_run_test(test_grow);
+    mu_run_test(test_free);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);